@@ -23,7 +23,10 @@
 #include "cyclic_rc/shared_ptr.h"
 
 #include <iostream>
-#include <boost/pool/pool.hpp>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
 
 namespace cyclic_rc { namespace details
 {
@@ -32,32 +35,44 @@ namespace cyclic_rc { namespace details
 //                      collector_initializer
 //------------------------------------------------------------
 collector_in * g_collector_in = nullptr;
-collector_it * g_collector_it = nullptr;
+collector_it * g_collector_it[max_domains] = {};
 
 // nifty counter
 static int g_counter = 0;
 
+// protects g_collector_it during creation and destruction of domains
+static spinlock* g_domain_mutex = nullptr;
+
+thread_local
+size_t current_domain::value    = 0;
+
+striped_rc_count::stripe striped_rc_count::m_stripes[striped_rc_count::n_stripes];
+
 bool collector_is_in_free<config_nothread, false>::value      = false;
 
 thread_local
 bool collector_is_in_free<config_thread, true>::value         = false;
 
-using obj_count_in  = obj_count<config_nothread>;
-using obj_count_it  = obj_count<config_thread>;
+template<bool multithread>
+typename local_roots<multithread>::root_type local_roots<multithread>::m_head
+                                    = {nullptr, &m_head, &m_head};
 
-//must be alive during global objects destruction
-obj_count_in::mutex_type* obj_count_in::m_mutex = nullptr;
-obj_count_it::mutex_type* obj_count_it::m_mutex = nullptr;
+template<bool multithread>
+size_t local_roots<multithread>::m_deferred = 0;
+
+template local_roots<false>;
+template local_roots<true>;
 
 collector_initializer::collector_initializer()
 {
     if (g_counter == 0)
     {
-        obj_count_in::m_mutex = new obj_count_in::mutex_type();
-        obj_count_it::m_mutex = new obj_count_it::mutex_type();
+        mutator_lock::m_mutex = new spinlock();
+        mutator_lock::m_orphan_roots = new mutator_lock::root_vector[max_domains];
+        g_domain_mutex  = new spinlock();
 
-        g_collector_in = new collector_in();
-        g_collector_it = new collector_it();
+        g_collector_in  = new collector_in(0);
+        g_collector_it[0] = new collector_it(0);
     };
 
     ++g_counter;
@@ -70,32 +85,81 @@ collector_initializer::~collector_initializer()
     if (g_counter == 0)   
     {
         delete g_collector_in;
-        delete g_collector_it;
+        delete g_collector_it[0];
+
+        g_collector_in  = nullptr;
+        g_collector_it[0] = nullptr;
 
-        g_collector_in = nullptr;
-        g_collector_it = nullptr;
+        delete g_domain_mutex;
+        g_domain_mutex  = nullptr;
 
-        delete obj_count_in::m_mutex;
-        delete obj_count_it::m_mutex;
+        delete mutator_lock::m_mutex;
+        mutator_lock::m_mutex = nullptr;
 
-        obj_count_in::m_mutex = nullptr;
-        obj_count_it::m_mutex = nullptr;
+        delete[] mutator_lock::m_orphan_roots;
+        mutator_lock::m_orphan_roots = nullptr;
+
+        // stripes buffer roots only in the CYCLIC_RC_MT_STRIPED mode
+        if (std::is_same<config_thread::mutator_lock_type, striped_lock>::value)
+            striped_lock::close();
     };
 }
 
+//------------------------------------------------------------
+//                      domains
+//------------------------------------------------------------
+size_t create_domain()
+{
+    std::lock_guard<spinlock> lock(*g_domain_mutex);
+
+    // domain 0 is created by collector_initializer
+    for (size_t i = 1; i < max_domains; ++i)
+    {
+        if (g_collector_it[i] != nullptr)
+            continue;
+
+        g_collector_it[i]   = new collector_it(i);
+        return i;
+    };
+
+    throw std::length_error("cyclic_rc: too many collector domains");
+};
+
+void destroy_domain(size_t domain)
+{
+    collector_it* c;
+
+    {
+        std::lock_guard<spinlock> lock(*g_domain_mutex);
+
+        assert(domain != 0 && g_collector_it[domain] != nullptr);
+
+        c                   = g_collector_it[domain];
+    };
+
+    // remaining garbage is freed by the destructor, which can release 
+    // objects and must find this collector
+    delete c;
+
+    std::lock_guard<spinlock> lock(*g_domain_mutex);
+    g_collector_it[domain]  = nullptr;
+};
+
 //------------------------------------------------------------
 //                      collector
 //------------------------------------------------------------
 
 template<class config>
-void collector<config>::mark()
+void collector<config>::mark(root_buffer& roots)
 {
     size_t pos      = 0;
-    size_t size     = m_objects_old->size();
+    size_t size     = roots.size();
 
 	while(pos < size)
 	{
-		auto ro     = (*m_objects_old)[pos];
+        prefetch_root(roots, pos);
+
+		auto ro     = roots[pos];
 
         if (ro->get_counter().is_old() == false)
         {
@@ -103,6 +167,8 @@ void collector<config>::mark()
         else if (ro->get_counter().is_purple() && ro->get_counter().get_cout_impl() > 0)
 		{
             ro->get_counter().mark_gray(ro);
+            process_work();
+
 			++pos;
             continue;
 		}
@@ -114,41 +180,149 @@ void collector<config>::mark()
                 free_object(ro);
 		};		
 
-        (*m_objects_old)[pos]   = m_objects_old->back();
+        roots[pos]  = roots.back();
 
-        m_objects_old->pop_back();
+        roots.pop_back();
         --size;
 	};
 };
 
 template<class config>
-void collector<config>::scan()
+void collector<config>::scan(root_buffer& roots)
 {
-	for(size_t i = 0; i < m_objects_old->size(); ++i)
-        (*m_objects_old)[i]->get_counter().scan((*m_objects_old)[i]);
+	for(size_t i = 0; i < roots.size(); ++i)
+    {
+        prefetch_root(roots, i);
+        roots[i]->get_counter().scan(roots[i]);
+        process_work();
+    };
 };
 
 template<class config>
-void collector<config>::collect_roots()
+void collector<config>::collect_roots(root_buffer& roots)
 {
-	for (size_t i = 0; i < m_objects_old->size(); ++i)
+    // roots are removed from the buffer; a root reached by collect_white
+    // from other root is freed immediately
+	for (size_t i = 0; i < roots.size(); ++i)
+	    roots[i]->get_counter().mark_nonbuffered();
+
+	for (size_t i = 0; i < roots.size(); ++i)
 	{
-	    (*m_objects_old)[i]->get_counter().mark_nonbuffered();
-        (*m_objects_old)[i]->get_counter().collect_white((*m_objects_old)[i]);
+        prefetch_root(roots, i);
+        roots[i]->get_counter().collect_white(roots[i]);
+        process_work();
 	};	
 
-    m_objects_old->clear();
+    roots.clear();
+};
+
+template<class config>
+void collector<config>::process_work()
+{
+    while (m_work.empty() == false)
+    {
+        work_item item  = m_work.back();
+        m_work.pop_back();
+
+        item.object->visit_children(item.type);
+    };
+};
+
+template<class config>
+void collector<config>::release_impl(slot_base* s)
+{
+    // s can be referenced by a local_ptr handle
+    if (defer_release_impl(s) == true)
+        return;
+
+    m_release.push_back(s);
+
+    // called by release_object; s will be processed by the loop below
+    if (m_releasing == true)
+        return;
+
+    process_release(release_budget);
+
+    // objects are not visited by the collector running concurrently;
+    // destructors are called only by free_objects with is_freeing set,
+    // therefore references dropped by them do not reenter this function
+    if (collecting == false && m_objects_to_free.size() >= free_batch)
+        process_free_objects();
+
+    // collection is not started while objects are released
+    start_collector_if_required();
+};
+
+template<class config>
+void collector<config>::process_release(size_t budget)
+{
+    m_releasing             = true;
+
+    for (size_t i = 0; i < budget && m_release.empty() == false; ++i)
+    {
+        slot_base* s        = m_release.back();
+        m_release.pop_back();
+
+        s->get_counter().release_object(s);
+    };
+
+    m_releasing             = false;
 };
 
 template<class config>
 bool collector<config>::process_buffers()
+{
+    if (m_root_snapshot == true)
+    {
+        for (int i = 0; i < n_medium; ++i)
+        {
+            details::age_type age   = (i == n_medium - 1) ? details::age_type::old 
+                                                          : details::age_type::medium; 
+            filter_snapshot(*m_objects_medium[i], age, false);
+        };
+
+        filter_snapshot(*m_objects_young, details::age_type::medium, true);
+    }
+    else
+    {
+        filter_buffers();
+    };
+
+    //swap buffers
+    root_buffer* prev       = m_objects_young;
+    
+    for (int i = 0; i < n_medium; ++i)
+    {
+        root_buffer* tmp    = m_objects_medium[i];
+        m_objects_medium[i] = prev;
+        prev                = tmp;
+    };
+    
+    m_objects_young     = std::move(m_objects_old);
+    m_objects_old       = std::move(prev);
+
+    for (int i = 0; i < n_medium; ++i)
+    {
+        if (m_objects_medium[i]->size() > 0)
+            return true;
+    };
+
+    if (m_objects_old->size() > 0)
+        return true;
+
+    return false;
+};
+
+
+template<class config>
+void collector<config>::filter_buffers()
 {
     size_t pos;
     size_t size;
 
     for (int i = 0; i < n_medium; ++i)
     {
-        root_vector& vec        = *m_objects_medium[i];
+        root_buffer& vec        = *m_objects_medium[i];
         details::age_type age   = (i == n_medium - 1) ? details::age_type::old 
                                                       : details::age_type::medium; 
 
@@ -157,6 +331,8 @@ bool collector<config>::process_buffers()
 
         while (pos < size)
         {
+            prefetch_root(vec, pos);
+
             obj_count& tmp = vec[pos]->get_counter();
 
             if (tmp.is_young() == true || tmp.is_buffered() == false)
@@ -195,13 +371,15 @@ bool collector<config>::process_buffers()
 
     while (pos < size)
     {
+        prefetch_root(*m_objects_young, pos);
+
         obj_count& tmp = (*m_objects_young)[pos]->get_counter();
 
         tmp.mark_age(details::age_type::medium);
         
         if (tmp.is_buffered() == false)
         {
-            //can be marked as nonbuffered during collect_white
+            //removed from the buffer by other path
         }
         else if (tmp.is_black() == true)
         {
@@ -226,30 +404,78 @@ bool collector<config>::process_buffers()
         m_objects_young->pop_back();
         --size;
     };
+};
 
-    //swap buffers
-    root_vector* prev       = m_objects_young;
-    
-    for (int i = 0; i < n_medium; ++i)
+template<class config>
+void collector<config>::filter_snapshot(root_buffer& roots, details::age_type age, 
+                                        bool young)
+{
+    // the same filter as in filter_buffers; state of all roots is copied to
+    // a dense array first, then the array is scanned sequentially and only
+    // objects, whose state changes, are accessed again; mutators are 
+    // stopped, therefore the copy remains valid
+    size_t size         = roots.size();
+    m_root_state.resize(size);
+
+    for (size_t pos = 0; pos < size; ++pos)
     {
-        root_vector* tmp    = m_objects_medium[i];
-        m_objects_medium[i] = prev;
-        prev                = tmp;
+        prefetch_root(roots, pos);
+
+        obj_count& tmp      = roots[pos]->get_counter();
+        unsigned char state = 0;
+
+        if (tmp.is_young() == true)
+            state           |= state_young;
+        if (tmp.is_buffered() == true)
+            state           |= state_buffered;
+        if (tmp.is_black() == true)
+            state           |= state_black;
+        if (tmp.get_cout_impl() == 0)
+            state           |= state_zero;
+
+        // all objects leaving the young buffer must become medium, 
+        // otherwise would not be buffered again
+        if (young == true)
+            tmp.mark_age(age);
+
+        m_root_state[pos]   = state;
     };
-    
-    m_objects_young     = std::move(m_objects_old);
-    m_objects_old       = std::move(prev);
 
-    for (int i = 0; i < n_medium; ++i)
+    size_t kept         = 0;
+
+    for (size_t pos = 0; pos < size; ++pos)
     {
-        if (m_objects_medium[i]->size() > 0)
-            return true;
-    };
+        unsigned char state = m_root_state[pos];
+        slot_base* s        = roots[pos];
 
-    if (m_objects_old->size() > 0)
-        return true;
+        // object is removed from older buffers when buffered again
+        if ((state & state_buffered) == 0 
+            || (young == false && (state & state_young) != 0))
+        {
+        }
+        else if ((state & state_black) != 0)
+        {
+            // the same object can be buffered twice, if it was removed from
+            // the buffer by other path; only the first entry is processed
+            if (s->get_counter().is_buffered() == false)
+                continue;
 
-    return false;
+            s->get_counter().mark_nonbuffered();
+
+            if ((state & state_zero) != 0)
+                this->free_object(s);
+        }
+        else
+        {
+            if (young == false)
+                s->get_counter().mark_age(age);
+
+            roots[kept]     = s;
+            ++kept;
+        };
+    };
+
+    roots.truncate(kept);
 };
 
 /*
@@ -261,23 +487,33 @@ static void empty_deleter(void*)
 
 template<class config>
 void collector<config>::process_free_objects()
+{
+    if (m_objects_to_free.empty() == true)
+        return;
+
+    m_stats.freed           += m_objects_to_free.size();
+    queue_free(m_objects_to_free);
+};
+
+template<class config>
+void collector<config>::free_objects(root_vector& objects, deleter_groups& buffer)
 {
     using is_free_type  = collector_is_in_free<config, multithreaded>;
 
-    using delete_func   = void (*)(void *);
-    using vec_deleters  = std::vector<delete_func>;
+    // free_objects called by a destructor cannot use buffers of the outer
+    // call
+    bool nested         = is_free_type::value;
+    deleter_groups local;
+    deleter_groups& groups  = (nested == true) ? local : buffer;
 
     is_free_type::value = true;
-    size_t n            = m_objects_to_free.size();
-
-    vec_deleters del;
-    del.reserve(n);
+    size_t n            = objects.size();
 
     for (size_t i = 0; i < n; ++i)
     {
-        slot_base* ptr = m_objects_to_free[i];
+        slot_base* ptr = objects[i];
 
-        del.push_back(ptr->get_deleter());
+        add_deleted(groups, ptr);
         ptr->get_counter().call_destructor(ptr);
         ptr->get_counter().mark_yellow();
 
@@ -296,63 +532,1344 @@ void collector<config>::process_free_objects()
         */
     };
 
-    for (size_t i = 0; i < n; ++i)
+    release_deleted(groups);
+
+    objects.clear();
+
+    is_free_type::value = nested;
+};
+
+template<class config>
+void collector<config>::add_deleted(deleter_groups& groups, slot_base* s)
+{
+    delete_func del     = s->get_deleter();
+
+    // only few deleters are used; batch deleter is read only once for each
+    // deleter
+    for (deleter_group& group : groups)
+    {
+        if (group.deleter == del)
+        {
+            group.objects.push_back(s);
+            return;
+        };
+    };
+
+    batch_delete_func batch = s->get_batch_deleter();
+
+    if (batch == nullptr && del == &slot_base::default_deleter)
+        batch           = &slot_base::default_batch_deleter;
+
+    groups.push_back(deleter_group{del, batch, std::vector<void*>()});
+    groups.back().objects.push_back(s);
+};
+
+template<class config>
+void collector<config>::release_deleted(deleter_groups& groups)
+{
+    for (deleter_group& group : groups)
+    {
+        size_t n        = group.objects.size();
+
+        if (n == 0)
+            continue;
+
+        if (group.batch_deleter != nullptr)
+        {
+            (*group.batch_deleter)(group.objects.data(), n);
+        }
+        else
+        {
+            for (size_t i = 0; i < n; ++i)
+                (*group.deleter)(group.objects[i]);
+        };
+
+        group.objects.clear();
+
+        // buffers are reused by next calls, but memory needed by a very 
+        // large batch is released
+        if (group.objects.capacity() > max_deleter_buffer)
+            std::vector<void*>().swap(group.objects);
+    };
+};
+
+//------------------------------------------------------------
+//                      free threads
+//------------------------------------------------------------
+// If free threads are set, then batches of unreachable objects are not
+// freed by the thread performing collection, but queued and freed by the 
+// free thread; additional free threads split a batch into chunks of 
+// free_chunk objects. Destructors of all objects in a batch are called 
+// before any deleter, as in free_objects.
+
+template<class config>
+void collector<config>::queue_free(root_vector& objects)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_free_mutex);
+
+        if (m_free_thread != nullptr)
+        {
+            m_free_queue.push_back(root_vector());
+            m_free_queue.back().swap(objects);
+
+            m_free_cond.notify_all();
+            return;
+        };
+    };
+
+    free_objects(objects, m_free_groups_inline);
+};
+
+template<class config>
+void collector<config>::free_thread()
+{
+    std::unique_lock<std::mutex> lock(m_free_mutex);
+
+    for (;;)
     {
-        slot_base* ptr  = m_objects_to_free[i];
-        delete_func df  = del[i];
+        m_free_cond.wait(lock, [this]() 
+            { 
+                return m_free_stop == true || m_free_queue.empty() == false;
+            });
+
+        // queued objects are freed before the thread is stopped
+        if (m_free_queue.empty() == true)
+            return;
+
+        root_vector objects;
+        objects.swap(m_free_queue.front());
+        m_free_queue.pop_front();
+
+        m_free_busy     = true;
+        lock.unlock();
 
-        (*df)(ptr);
+        if (m_free_pool != nullptr && objects.size() > free_chunk)
+            free_objects_parallel(objects);
+        else
+            free_objects(objects, m_free_groups[0]);
+
+        lock.lock();
+        m_free_busy     = false;
+
+        m_free_cond.notify_all();
     };
+};
 
-    m_objects_to_free.clear();
-    del.clear();
+template<class config>
+void collector<config>::free_objects_parallel(root_vector& objects)
+{
+    size_t n            = objects.size();
+    std::vector<free_item> items;
+
+    m_free_batch        = &objects;
+
+    // each worker collects destroyed objects in own deleter groups
+    m_free_destroy      = true;
+
+    for (size_t first = 0; first < n; first += free_chunk)
+        items.push_back(free_item{first, std::min(first + free_chunk, n)});
+
+    m_free_pool->run(items, &collector::process_free, this);
+
+    // all destructors must be finished before memory is released
+    m_free_destroy      = false;
+
+    for (size_t i = 0; i < m_free_groups.size(); ++i)
+        items.push_back(free_item{i, i + 1});
+
+    m_free_pool->run(items, &collector::process_free, this);
+
+    objects.clear();
+    m_free_batch        = nullptr;
+};
+
+template<class config>
+void collector<config>::process_free(void* context, const free_item& item)
+{
+    using is_free_type  = collector_is_in_free<config, multithreaded>;
+
+    collector* owner    = static_cast<collector*>(context);
+    root_vector& objects= *owner->m_free_batch;
+
+    is_free_type::value = true;
+
+    if (owner->m_free_destroy == true)
+    {
+        deleter_groups& groups  = owner->m_free_groups[free_pool_type::get_worker_index()];
+
+        for (size_t i = item.first; i < item.last; ++i)
+        {
+            slot_base* ptr  = objects[i];
+
+            add_deleted(groups, ptr);
+            ptr->get_counter().call_destructor(ptr);
+            ptr->get_counter().mark_yellow();
+        };
+    }
+    else
+    {
+        // item.first is index of a worker
+        release_deleted(owner->m_free_groups[item.first]);
+    };
 
     is_free_type::value = false;
 };
 
 template<class config>
-void collector<config>::collect_impl(bool collect_all)
+void collector<config>::set_free_threads_impl(size_t n_threads)
 {
-	if (collecting == true)
-		return;
+    std::thread* thread;
 
-	collecting				= true;
+    {
+        std::lock_guard<std::mutex> lock(m_free_mutex);
 
-    int n                   = (collect_all? 2 + n_medium: 1);
+        thread          = m_free_thread;
+        m_free_stop     = true;
 
-    process_free_objects();
+        m_free_cond.notify_all();
+    };
 
-    for (int i = 0; i < n; ++i)
+    // batches are queued until the thread is joined; buffers used by the 
+    // free thread cannot be used by the collecting thread at the same time
+    if (thread != nullptr)
     {
-	    mark();
-	    scan();
-	    collect_roots();
+        thread->join();
+        delete thread;
+    };
 
-        process_buffers();
+    {
+        std::unique_lock<std::mutex> lock(m_free_mutex);
+
+        // batches queued after the thread was finished
+        while (m_free_queue.empty() == false)
+        {
+            root_vector objects;
+            objects.swap(m_free_queue.front());
+            m_free_queue.pop_front();
+
+            m_free_busy = true;
+            lock.unlock();
+
+            free_objects(objects, m_free_groups[0]);
+
+            lock.lock();
+            m_free_busy = false;
+        };
+
+        m_free_thread   = nullptr;
+        m_free_cond.notify_all();
     };
 
-    process_free_objects();
+    delete m_free_pool;
+    m_free_pool         = nullptr;
+    m_free_groups.resize(1);
 
-	collecting				= false;
+    // destructors called by other threads must see thread local is_freeing
+    if (n_threads == 0 || multithreaded == false)
+        return;
+
+    if (n_threads > 1)
+    {
+        m_free_pool     = new free_pool_type(n_threads - 1);
+        m_free_groups.resize(n_threads);
+    };
+
+    std::lock_guard<std::mutex> lock(m_free_mutex);
+
+    m_free_stop         = false;
+    m_free_thread       = new std::thread(&collector::free_thread, this);
 };
 
 template<class config>
-collector<config>::collector()
+void collector<config>::wait_free_impl()
 {
-	collecting          = false;
-	allocated_memory    = 0;
-
-    m_objects_old       = new root_vector();
-    m_objects_young     = new root_vector();
+    std::unique_lock<std::mutex> lock(m_free_mutex);
 
-    for (int i = 0; i < n_medium; ++i)
-        m_objects_medium[i] = new root_vector();
+    m_free_cond.wait(lock, [this]() 
+        { 
+            return m_free_queue.empty() == true && m_free_busy == false;
+        });
 };
 
 template<class config>
-collector<config>::~collector()
+void collector<config>::collect_impl(bool collect_all)
 {
-	collect_impl(true);
+	if (collecting == true)
+		return;
+
+	collecting				= true;
+    m_requested             = false;
+
+    reset_memory();
+
+    mutator_lock::stop_mutators(m_domain);
+    mutator_lock::flush_all_roots(m_domain, *m_objects_young);
+
+    int n                   = (collect_all? 2 + n_medium: 1);
+    size_t n_roots          = 0;
+
+    reconcile_deferred();
+    pin_locals();
+
+    // objects left by release must be released before buffers are processed,
+    // otherwise could be freed twice
+    process_release(size_t(-1));
+    process_free_objects();
+
+    for (int i = 0; i < n; ++i)
+    {
+        n_roots             += m_objects_old->size();
+
+        if (use_parallel() == true)
+        {
+            mark_parallel(*m_objects_old);
+            scan_parallel(*m_objects_old);
+            collect_roots_parallel(*m_objects_old);
+        }
+        else
+        {
+	        mark(*m_objects_old);
+	        scan(*m_objects_old);
+	        collect_roots(*m_objects_old);
+        };
+
+        process_buffers();
+    };
+
+    unpin_locals();
+
+    m_stats.roots           += n_roots;
+    m_stats.collections     += 1;
+
+    if (collect_all == false)
+        adapt_threshold(n_roots, m_objects_to_free.size());
+
+    process_free_objects();
+
+    // memory of freed objects is no longer counted, unless objects are 
+    // freed by free threads
+    reset_memory();
+
+    mutator_lock::resume_mutators(m_domain);
+
+	collecting				= false;
+};
+
+//------------------------------------------------------------
+//                      concurrent collection
+//------------------------------------------------------------
+// Concurrent collection is performed in three phases:
+//  1. mutators are stopped and possible roots of cycles are selected from
+//     the old buffer; roots remain buffered, therefore cannot be freed until
+//     the third phase
+//  2. trial deletion (mark gray, scan, collect white) is performed without
+//     the global lock on copies of reference counters stored in m_crc_table;
+//     mutators can modify the object graph, therefore found white objects
+//     are only candidates
+//  3. mutators are stopped and the candidate set is validated: an object
+//     remains in the set only if all references to this object come from 
+//     other members of the set; removing an object can invalidate other 
+//     objects, therefore validation is repeated until no object is removed;
+//     remaining objects are garbage and are released
+// Destructors of garbage objects are called after mutators are resumed.
+
+template<class config>
+void collector<config>::collect_concurrent_impl(bool collect_all)
+{
+    std::unique_lock<mutex_type> lock(m_mutex);
+
+    // collection called from destructors of garbage objects
+	if (collecting == true && is_freeing() == true)
+		return;
+
+    // global lock is released during collection; wait until the current 
+    // collection is finished
+    m_collect_cond.wait(lock, [this]() { return collecting == false; });
+
+	collecting				= true;
+    m_requested             = false;
+
+    reset_memory();
+
+    int n                   = (collect_all? 2 + n_medium: 1);
+    size_t n_roots          = 0;
+    size_t n_freed          = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        // objects left by release must be released before buffers are 
+        // processed, otherwise could be freed twice
+        process_release(size_t(-1));
+
+        mutator_lock::stop_mutators(m_domain);
+        n_roots             += m_objects_old->size();
+        mark_concurrent();
+        mutator_lock::resume_mutators(m_domain);
+
+        lock.unlock();
+        trial_deletion();
+        lock.lock();
+
+        mutator_lock::stop_mutators(m_domain);
+        mutator_lock::flush_all_roots(m_domain, *m_objects_young);
+
+        // mutators could leave objects in the release queue; these objects 
+        // must be released before candidates are validated, otherwise roots
+        // with zero count could be freed twice
+        process_release(size_t(-1));
+
+        validate_candidates();
+        collect_candidates();
+        process_buffers();
+
+        root_vector objects_to_free;
+        objects_to_free.swap(m_objects_to_free);
+        n_freed             += objects_to_free.size();
+        m_stats.freed       += objects_to_free.size();
+
+        mutator_lock::resume_mutators(m_domain);
+
+        // garbage objects are no longer accessible
+        lock.unlock();
+        queue_free(objects_to_free);
+        lock.lock();
+    };
+
+    m_stats.roots           += n_roots;
+    m_stats.collections     += 1;
+
+    if (collect_all == false)
+        adapt_threshold(n_roots, n_freed);
+
+    reset_memory();
+
+	collecting				= false;
+    m_collect_cond.notify_all();
+};
+
+template<class config>
+void collector<config>::mark_concurrent()
+{
+    size_t pos      = 0;
+    size_t size     = m_objects_old->size();
+
+	while(pos < size)
+	{
+		auto ro     = (*m_objects_old)[pos];
+
+        if (ro->get_counter().is_old() == false)
+        {
+        }
+        else if (ro->get_counter().is_purple() && ro->get_counter().get_cout_impl() > 0)
+		{
+            // purple objects are not buffered again when reference count is
+            // decreased; roots decreased during trial deletion must be added
+            // to the young buffer, otherwise would be lost in the third phase
+            ro->get_counter().mark_black();
+			++pos;
+            continue;
+		}
+		else
+		{
+            ro->get_counter().mark_nonbuffered();			
+
+			if(ro->get_counter().is_black() && ro->get_counter().is_count_zero())
+                free_object(ro);
+		};		
+
+        (*m_objects_old)[pos]   = m_objects_old->back();
+
+        m_objects_old->pop_back();
+        --size;
+	};
+};
+
+template<class config>
+void collector<config>::trial_deletion()
+{
+    root_buffer& roots  = *m_objects_old;
+
+	for(size_t i = 0; i < roots.size(); ++i)
+    {
+        crc_mark_gray(roots[i]);
+        process_work();
+    };
+
+	for(size_t i = 0; i < roots.size(); ++i)
+    {
+        crc_scan(roots[i]);
+        process_work();
+    };
+
+	for(size_t i = 0; i < roots.size(); ++i)
+    {
+        crc_collect_white(roots[i]);
+        process_work();
+    };
+};
+
+template<class config>
+void collector<config>::validate_candidates()
+{
+    // objects released by mutators no longer hold references to children
+    for (slot_base* s : m_candidates)
+    {
+        if (s->get_counter().get_cout_impl() == 0)
+            m_crc_table[s].color    = crc_color::removed;
+        else
+            m_crc_table[s].count    = 0;
+    };
+
+    // count references from members of the candidate set
+    for (slot_base* s : m_candidates)
+    {
+        if (m_crc_table[s].color == crc_color::member)
+            s->visit_children((int)collect_type::crc_count);
+    };
+
+    for (slot_base* s : m_candidates)
+    {
+        crc_info& info  = m_crc_table[s];
+
+        if (info.color == crc_color::member 
+            && info.count != s->get_counter().get_cout_impl())
+        {
+            crc_remove(s);
+            process_work();
+        };
+    };
+
+    size_t pos      = 0;
+    size_t size     = m_candidates.size();
+
+    while (pos < size)
+    {
+        if (m_crc_table[m_candidates[pos]].color == crc_color::member)
+        {
+            ++pos;
+            continue;
+        };
+
+        m_candidates[pos]   = m_candidates.back();
+        m_candidates.pop_back();
+        --size;
+    };
+};
+
+template<class config>
+void collector<config>::collect_candidates()
+{
+    // references from garbage to other objects are removed
+    for (slot_base* s : m_candidates)
+        s->visit_children((int)collect_type::crc_release);
+
+    // released objects must be processed before remaining roots
+    process_release(size_t(-1));
+
+    for (slot_base* s : m_candidates)
+    {
+        s->get_counter().mark_black();
+        s->get_counter().mark_nonbuffered();
+        free_object(s);
+    };
+
+    // remaining roots are either accessible or released by mutators
+    for (slot_base* s : *m_objects_old)
+    {
+        crc_info* info  = find_crc(s);
+        obj_count& tmp  = s->get_counter();
+
+        if (info != nullptr && info->color == crc_color::member)
+            continue;
+
+        if (tmp.is_old() == false)
+            continue;
+
+        tmp.mark_nonbuffered();
+
+        if (tmp.is_count_zero() == true)
+            free_object(s);
+        else
+            tmp.mark_black();
+    };
+
+    m_objects_old->clear();
+    m_candidates.clear();
+    m_crc_table.clear();
+};
+
+template<class config>
+typename collector<config>::crc_info& 
+collector<config>::get_crc(slot_base* s)
+{
+    auto pos = m_crc_table.find(s);
+
+    if (pos != m_crc_table.end())
+        return pos->second;
+
+    crc_info info;
+    info.count  = s->get_counter().get_cout_impl();
+    info.color  = crc_color::black;
+
+    return m_crc_table.insert(pos, std::make_pair(s, info))->second;
+};
+
+template<class config>
+typename collector<config>::crc_info* 
+collector<config>::find_crc(slot_base* s)
+{
+    auto pos = m_crc_table.find(s);
+
+    if (pos == m_crc_table.end())
+        return nullptr;
+
+    return &pos->second;
+};
+
+template<class config>
+void collector<config>::crc_mark_gray(slot_base* s)
+{
+    crc_info& info  = get_crc(s);
+
+	if (info.color != crc_color::gray)
+	{
+		info.color  = crc_color::gray;
+        m_work.push_back(work_item{s, (int)collect_type::crc_decrease});
+	};
+};
+
+template<class config>
+void collector<config>::crc_decrease_child(slot_base* s)
+{
+    crc_info& info  = get_crc(s);
+
+    // reference count could be decreased after the copy was created
+    if (info.count > 0)
+        --info.count;
+
+    crc_mark_gray(s);
+};
+
+template<class config>
+void collector<config>::crc_scan(slot_base* s)
+{
+    crc_info& info  = get_crc(s);
+
+	if (info.color == crc_color::gray)
+	{
+		if (info.count > 0)
+		{
+			crc_scan_black(s);
+		}
+		else
+		{
+			info.color  = crc_color::white;
+            m_work.push_back(work_item{s, (int)collect_type::crc_scan});
+		}				
+	};
+};
+
+template<class config>
+void collector<config>::crc_scan_black(slot_base* s)
+{
+	get_crc(s).color    = crc_color::black;
+    m_work.push_back(work_item{s, (int)collect_type::crc_scan_black});
+};
+
+template<class config>
+void collector<config>::crc_scan_black_child(slot_base* s)
+{
+    crc_info& info  = get_crc(s);
+    ++info.count;
+
+	if (info.color != crc_color::black)
+		crc_scan_black(s);
+};
+
+template<class config>
+void collector<config>::crc_collect_white(slot_base* s)
+{
+    crc_info& info  = get_crc(s);
+
+	if (info.color == crc_color::white)
+	{
+        info.color  = crc_color::member;
+        m_candidates.push_back(s);
+
+        m_work.push_back(work_item{s, (int)collect_type::crc_collect_white});
+	};
+};
+
+template<class config>
+void collector<config>::crc_count_child(slot_base* s)
+{
+    crc_info* info  = find_crc(s);
+
+    if (info != nullptr && info->color == crc_color::member)
+        ++info->count;
+};
+
+template<class config>
+void collector<config>::crc_remove(slot_base* s)
+{
+    // s is not garbage, therefore objects referenced by s are not garbage
+    find_crc(s)->color  = crc_color::removed;
+    m_work.push_back(work_item{s, (int)collect_type::crc_remove});
+};
+
+template<class config>
+void collector<config>::crc_remove_child(slot_base* s)
+{
+    crc_info* info  = find_crc(s);
+
+    if (info != nullptr && info->color == crc_color::member)
+        crc_remove(s);
+};
+
+template<class config>
+void collector<config>::crc_release_child(slot_base* s)
+{
+    crc_info* info  = find_crc(s);
+
+    if (info != nullptr && info->color == crc_color::member)
+        return;
+
+    s->get_counter().decrease_refcount_child(s);
+};
+
+template<class config>
+void collector<config>::visit_concurrent(slot_base* s, int type)
+{
+    collector* c    = get(s);
+
+	switch((collect_type)type)
+	{
+        case collect_type::crc_decrease:
+            return c->crc_decrease_child(s);
+        case collect_type::crc_scan:
+            return c->crc_scan(s);
+        case collect_type::crc_scan_black:
+            return c->crc_scan_black_child(s);
+        case collect_type::crc_collect_white:
+            return c->crc_collect_white(s);
+        case collect_type::crc_count:
+            return c->crc_count_child(s);
+        case collect_type::crc_remove:
+            return c->crc_remove_child(s);
+        case collect_type::crc_release:
+            return c->crc_release_child(s);
+        default:
+            return;
+	};
+};
+
+//------------------------------------------------------------
+//                      parallel trial deletion
+//------------------------------------------------------------
+// Mutators are stopped and phases of trial deletion (mark gray, scan, 
+// collect white) are performed by threads from m_pool. Objects can be 
+// visited by many threads, therefore counters are updated using atomic
+// operations and children of an object are visited only by the thread,
+// that changed the color of this object. Result of each phase does not 
+// depend on the order, in which objects are visited.
+
+template<class config>
+bool collector<config>::use_parallel() const
+{
+    return m_pool != nullptr && m_objects_old->size() >= parallel_min_roots;
+};
+
+template<class config>
+void collector<config>::mark_parallel(root_buffer& roots)
+{
+    size_t pos      = 0;
+    size_t size     = roots.size();
+
+    // roots are selected in the same way as in mark
+	while(pos < size)
+	{
+        prefetch_root(roots, pos);
+
+		auto ro     = roots[pos];
+
+        if (ro->get_counter().is_old() == false)
+        {
+        }
+        else if (ro->get_counter().is_purple() && ro->get_counter().get_cout_impl() > 0)
+		{
+			++pos;
+            continue;
+		}
+		else
+		{
+            ro->get_counter().mark_nonbuffered();			
+
+			if(ro->get_counter().is_black() && ro->get_counter().is_count_zero())
+                free_object(ro);
+		};		
+
+        roots[pos]  = roots.back();
+
+        roots.pop_back();
+        --size;
+	};
+
+    for (slot_base* s : roots)
+    {
+        if (s->get_counter().m_counter.try_mark_gray() == true)
+            m_parallel_items.push_back(work_item{s, (int)collect_type::par_decrease});
+    };
+
+    m_pool->run(m_parallel_items, &collector::process_parallel, this);
+};
+
+template<class config>
+void collector<config>::scan_parallel(root_buffer& roots)
+{
+    for (slot_base* s : roots)
+    {
+        bool is_black;
+
+        if (s->get_counter().m_counter.try_scan(is_black) == false)
+            continue;
+
+        int type    = is_black ? (int)collect_type::par_scan_black 
+                               : (int)collect_type::par_scan;
+        m_parallel_items.push_back(work_item{s, type});
+    };
+
+    m_pool->run(m_parallel_items, &collector::process_parallel, this);
+};
+
+template<class config>
+void collector<config>::collect_roots_parallel(root_buffer& roots)
+{
+    // roots are removed from the buffer as in collect_roots; buffered bits
+    // are not changed while collector threads are running
+    for (slot_base* s : roots)
+        s->get_counter().mark_nonbuffered();
+
+    for (slot_base* s : roots)
+    {
+        if (s->get_counter().m_counter.try_collect_white() == true)
+        {
+            m_parallel_items.push_back(work_item{s, (int)collect_type::par_collect_white});
+            m_parallel_free[0].push_back(s);
+        };
+    };
+
+    m_pool->run(m_parallel_items, &collector::process_parallel, this);
+
+    for (root_vector& objects : m_parallel_free)
+    {
+        for (slot_base* s : objects)
+        {
+            // references to acyclic objects cannot be removed by collector 
+            // threads, since acyclic objects can be released
+            s->visit_children((int)collect_type::release_acyclic);
+
+            // object stored in a buffer is black with zero count and is 
+            // freed when removed from the buffer (as in collect_white)
+            if (s->get_counter().is_buffered() == false)
+                free_object(s);
+        };
+
+        objects.clear();
+    };
+
+    roots.clear();
+};
+
+template<class config>
+void collector<config>::process_parallel(void* context, const work_item& item)
+{
+    (void)context;
+    item.object->visit_children(item.type);
+};
+
+template<class config>
+void collector<config>::visit_parallel(slot_base* s, int type)
+{
+    get(s)->visit_parallel_impl(s, type);
+};
+
+template<class config>
+void collector<config>::visit_parallel_impl(slot_base* s, int type)
+{
+    auto& counter   = s->get_counter().m_counter;
+
+	switch((collect_type)type)
+	{
+        case collect_type::par_decrease:
+        {
+            counter.decrease_count_parallel();
+
+            if (counter.try_mark_gray() == true)
+                pool_type::push(work_item{s, type});
+
+            return;
+        }
+        case collect_type::par_scan:
+        {
+            bool is_black;
+
+            if (counter.try_scan(is_black) == false)
+                return;
+
+            int new_type    = is_black ? (int)collect_type::par_scan_black 
+                                       : (int)collect_type::par_scan;
+            pool_type::push(work_item{s, new_type});
+            return;
+        }
+        case collect_type::par_scan_black:
+        {
+            if (counter.increase_count_scan_black() == true)
+                pool_type::push(work_item{s, type});
+
+            return;
+        }
+        case collect_type::par_collect_white:
+        {
+            if (counter.try_collect_white() == false)
+                return;
+
+            pool_type::push(work_item{s, type});
+            m_parallel_free[pool_type::get_worker_index()].push_back(s);
+            return;
+        }
+        default:
+            return;
+	};
+};
+
+template<class config>
+void collector<config>::set_threads_impl(size_t n_threads)
+{
+    delete m_pool;
+    m_pool          = nullptr;
+
+    // parallel collection requires atomic counters
+    if (n_threads <= 1 || config::is_lock_free == false)
+        return;
+
+    m_pool          = new pool_type(n_threads - 1);
+    m_parallel_free.resize(n_threads);
+};
+
+template<class config>
+void collector<config>::request_collection()
+{
+    // signal the collector thread only once; called with the global lock
+    // held or by add_allocated
+    if (m_requested.exchange(true) == true)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_thread_mutex);
+    m_thread_cond.notify_one();
+};
+
+template<class config>
+void collector<config>::background_thread()
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_thread_mutex);
+
+            m_thread_cond.wait(lock, [this]() 
+                { 
+                    return m_stop_thread == true || m_requested.load() == true;
+                });
+
+            if (m_stop_thread == true)
+                return;
+        };
+
+        // m_requested is cleared by collect_impl
+        obj_count::collect(false, m_domain);
+    };
+};
+
+template<class config>
+void collector<config>::start_background_impl()
+{
+    std::lock_guard<std::mutex> lock(m_thread_mutex);
+
+    if (m_thread != nullptr)
+        return;
+
+    m_stop_thread       = false;
+    m_thread            = new std::thread(&collector::background_thread, this);
+
+    m_background.store(true);
+};
+
+template<class config>
+void collector<config>::stop_background_impl()
+{
+    std::thread* thread;
+
+    {
+        std::lock_guard<std::mutex> lock(m_thread_mutex);
+
+        if (m_thread == nullptr)
+            return;
+
+        m_background.store(false);
+
+        m_stop_thread   = true;
+        thread          = m_thread;
+        m_thread        = nullptr;
+
+        m_thread_cond.notify_one();
+    };
+
+    thread->join();
+    delete thread;
+};
+
+template<class config>
+bool collector<config>::collect_step_impl(size_t max_roots, time_point deadline)
+{
+    // concurrent collection is running
+	if (collecting == true)
+		return true;
+
+	collecting				= true;
+
+    mutator_lock::stop_mutators(m_domain);
+    mutator_lock::flush_all_roots(m_domain, *m_objects_young);
+
+    reconcile_deferred();
+    pin_locals();
+
+    size_t n_processed      = 0;
+    bool more               = true;
+
+    // at least one step is performed; garbage found by a step is freed by 
+    // this step, since destructors can access other objects of the same 
+    // garbage cycle
+    for (;;)
+    {
+        // objects in the release queue have zero count, but can be still 
+        // stored in buffers; roots are processed when the queue is empty
+        if (m_release.empty() == false)
+        {
+            process_release(step_roots);
+            process_free_objects();
+        }
+        else
+        {
+            // previous pass is finished; start next pass
+            if (m_objects_old->empty() == true)
+                process_buffers();
+
+            size_t n        = std::min(max_roots - n_processed, step_roots);
+            n               = std::min(n, m_objects_old->size());
+            size_t first    = m_objects_old->size() - n;
+
+            for (size_t i = first; i < m_objects_old->size(); ++i)
+                m_objects_step.push_back((*m_objects_old)[i]);
+
+            m_objects_old->truncate(first);
+
+            mark(m_objects_step);
+            scan(m_objects_step);
+            collect_roots(m_objects_step);
+
+            process_free_objects();
+
+            n_processed     += n;
+            more            = m_objects_old->empty() == false;
+
+            if (more == false || n_processed >= max_roots)
+                break;
+        };
+
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+    };
+
+    unpin_locals();
+
+    m_stats.roots           += n_processed;
+    m_stats.collections     += 1;
+
+    mutator_lock::resume_mutators(m_domain);
+
+	collecting				= false;
+
+    return more;
+};
+
+template<class config>
+void collector<config>::adapt_threshold(size_t n_roots, size_t n_freed)
+{
+    // most roots are alive; collections are too frequent
+    if (n_freed * grow_ratio < n_roots)
+        m_threshold     = m_threshold * 2;
+
+    // collection found at least one garbage object per root
+    else if (n_freed >= n_roots)
+        m_threshold     = m_threshold / 2;
+
+    m_threshold         = std::max(m_threshold, m_min_threshold);
+    m_threshold         = std::min(m_threshold, m_max_threshold);
+};
+
+template<class config>
+void collector<config>::set_threshold_impl(size_t min_threshold, size_t max_threshold)
+{
+    m_min_threshold     = std::max(min_threshold, size_t(1));
+    m_max_threshold     = std::max(max_threshold, m_min_threshold);
+
+    m_threshold         = std::max(m_threshold, m_min_threshold);
+    m_threshold         = std::min(m_threshold, m_max_threshold);
+};
+
+//------------------------------------------------------------
+//                      deferred reference counting
+//------------------------------------------------------------
+// local_ptr handles do not change reference counters. While a handle exists,
+// an object whose reference count drops to zero can still be referenced by
+// the handle; such object is stored in the zero count table (m_deferred) 
+// together with one reference owned by the table. The table is reconciled
+// with the list of handles: objects not referenced by any handle lose the
+// reference of the table and are released; during reconciliation only 
+// objects referenced by handles are deferred again. References from handles
+// are not visible to trial deletion, therefore objects referenced by 
+// handles are pinned during a collection.
+//
+// The first modification of a field_ptr since the last reconciliation is 
+// logged in m_updates together with the old value of the field; next 
+// modifications do not change reference counts (update coalescing of 
+// Levanoni and Petrank). While the log is not empty, objects whose count 
+// drops to zero are deferred as well. Before the zero count table is 
+// reconciled, current values of logged fields are counted and then old values
+// are released.
+
+template<class config>
+bool collector<config>::defer_release_impl(slot_base* s)
+{
+    using local_list    = local_roots<multithreaded>;
+
+    if (multithreaded == true)
+        return false;
+
+    if (local_list::empty() == true && m_updates.empty() == true)
+        return false;
+
+    if (m_reconciling == true && std::binary_search(m_local_objects.begin(),
+                                    m_local_objects.end(), s) == false)
+    {
+        return false;
+    };
+
+    s->get_counter().increase_refcount_impl();
+
+    m_deferred.push_back(s);
+    local_list::m_deferred  = m_deferred.size();
+
+    if (m_deferred.size() >= m_deferred_limit)
+        release_deferred_impl();
+
+    return true;
+};
+
+template<class config>
+void collector<config>::release_deferred_impl()
+{
+    // references cannot be removed while destructors of garbage are called;
+    // the table is reconciled by the next call or by the next collection
+    if (collecting == true || m_reconciling == true || is_freeing() == true)
+        return;
+
+    reconcile_deferred();
+    start_collector_if_required();
+};
+
+template<class config>
+void collector<config>::reconcile_deferred()
+{
+    using local_list    = local_roots<multithreaded>;
+
+    if (m_deferred.empty() == true && m_updates.empty() == true)
+        return;
+
+    m_local_objects.clear();
+
+    for (auto r = local_list::begin(); r != local_list::end(); r = r->next)
+    {
+        if (r->object != nullptr)
+            m_local_objects.push_back(r->object);
+    };
+
+    std::sort(m_local_objects.begin(), m_local_objects.end());
+
+    m_reconciling       = true;
+
+    apply_updates();
+
+    size_t n            = m_deferred.size();
+    size_t kept         = 0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        slot_base* s    = m_deferred[i];
+
+        if (std::binary_search(m_local_objects.begin(), m_local_objects.end(), s))
+            m_deferred[kept++]  = s;
+        else
+            drop_deferred(s);
+    };
+
+    // objects deferred by drop_deferred are stored after n
+    m_deferred.erase(m_deferred.begin() + kept, m_deferred.begin() + n);
+
+    m_reconciling       = false;
+
+    local_list::m_deferred  = m_deferred.size();
+    m_deferred_limit    = std::max(min_deferred_limit, 2 * m_deferred.size());
+};
+
+template<class config>
+void collector<config>::drop_deferred(slot_base* s)
+{
+    // remove the reference owned by the zero count table; the object can be
+    // referenced from other objects since it was deferred
+    obj_count::decrease_refcount_impl(s);
+};
+
+template<class config>
+size_t collector<config>::log_update_impl(logged_field<multithreaded>* field)
+{
+    if (m_updates.size() >= update_limit)
+        release_deferred_impl();
+
+    m_updates.push_back(field_update{field, field->m_object});
+    return m_updates.size();
+};
+
+template<class config>
+void collector<config>::cancel_update_impl(size_t pos)
+{
+    // the old value is released by the next reconciliation; the current 
+    // value was never counted
+    m_updates[pos - 1].field    = nullptr;
+};
+
+template<class config>
+void collector<config>::apply_updates()
+{
+    if (m_updates.empty() == true)
+        return;
+
+    // reference counts are exact after new values are counted; old values
+    // are released with the log already empty
+    m_updates_work.swap(m_updates);
+
+    for (const field_update& update : m_updates_work)
+    {
+        logged_field<multithreaded>* field  = update.field;
+
+        if (field == nullptr)
+            continue;
+
+        field->m_log    = 0;
+
+        if (field->m_object != nullptr)
+            field->m_object->get_counter().increase_refcount_impl();
+    };
+
+    for (const field_update& update : m_updates_work)
+    {
+        if (update.old != nullptr)
+            obj_count::decrease_refcount_impl(update.old);
+    };
+
+    m_updates_work.clear();
+};
+
+template<class config>
+void collector<config>::pin_locals()
+{
+    using local_list    = local_roots<multithreaded>;
+
+    for (auto r = local_list::begin(); r != local_list::end(); r = r->next)
+    {
+        if (r->object != nullptr)
+            r->object->get_counter().increase_refcount_impl();
+    };
+};
+
+template<class config>
+void collector<config>::unpin_locals()
+{
+    using local_list    = local_roots<multithreaded>;
+
+    // objects, whose reference count drops to zero, are deferred
+    for (auto r = local_list::begin(); r != local_list::end(); r = r->next)
+    {
+        if (r->object != nullptr)
+            obj_count::decrease_refcount_impl(r->object);
+    };
+};
+
+template<class config>
+collector<config>::collector(size_t domain)
+{
+    m_domain            = domain;
+	collecting          = false;
+	m_allocated_memory  = 0;
+    m_memory_limit      = default_memory_threshold;
+    m_root_memory       = 0;
+    m_memory_threshold  = default_memory_threshold;
+    m_prefetch_distance = default_prefetch_distance;
+    m_root_snapshot     = false;
+    m_stats             = collector_stats{0, 0, 0};
+    m_releasing         = false;
+    m_pool              = nullptr;
+
+    m_free_thread       = nullptr;
+    m_free_pool         = nullptr;
+    m_free_busy         = false;
+    m_free_stop         = false;
+    m_free_batch        = nullptr;
+    m_free_destroy      = false;
+    m_free_groups.resize(1);
+
+    m_threshold         = default_threshold;
+    m_min_threshold     = default_min_threshold;
+    m_max_threshold     = default_max_threshold;
+
+    m_thread            = nullptr;
+    m_stop_thread       = false;
+    m_background        = false;
+    m_requested         = false;
+    m_concurrent        = false;
+
+    m_deferred_limit    = min_deferred_limit;
+    m_reconciling       = false;
+
+    m_objects_old       = new root_buffer();
+    m_objects_young     = new root_buffer();
+
+    for (int i = 0; i < n_medium; ++i)
+        m_objects_medium[i] = new root_buffer();
+};
+
+template<class config>
+collector<config>::~collector()
+{
+    stop_background_impl();
+	collect_impl(true);
+
+    // objects queued by the last collection are freed before the free 
+    // thread is stopped
+    set_free_threads_impl(0);
+
+    delete m_pool;
 };
 
 template collector<config_nothread>;
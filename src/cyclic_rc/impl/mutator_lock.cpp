@@ -0,0 +1,264 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "cyclic_rc/details/mutator_lock.h"
+#include "cyclic_rc/details/obj_count.h"
+
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <linux/membarrier.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace cyclic_rc { namespace details
+{
+
+//------------------------------------------------------------
+//                      mutator_lock
+//------------------------------------------------------------
+std::atomic<int> mutator_lock::m_stopped[max_domains] = {};
+spinlock* mutator_lock::m_mutex             = nullptr;
+mutator_state* mutator_lock::m_threads      = nullptr;
+
+//must be alive during global objects destruction
+mutator_lock::root_vector* mutator_lock::m_orphan_roots = nullptr;
+
+thread_local
+mutator_state* mutator_thread::value        = nullptr;
+
+thread_local
+bool mutator_thread::exiting                = false;
+
+// unregisters a thread, when the thread exits
+struct mutator_state_owner
+{
+    mutator_state*  m_state;
+
+    mutator_state_owner()
+        :m_state(nullptr)
+    {};
+
+    ~mutator_state_owner()
+    {
+        // this object can be destroyed before other thread-local objects
+        // holding references; these references are then updated under the
+        // global lock
+        mutator_thread::exiting = true;
+
+        if (m_state != nullptr)
+            mutator_lock::unregister_thread(m_state);
+    };
+};
+
+static thread_local mutator_state_owner g_state_owner;
+
+mutator_state* mutator_lock::register_thread()
+{
+    mutator_state* state    = new mutator_state();
+    state->m_active         = 0;
+    state->m_prev           = nullptr;
+
+    {
+        std::lock_guard<spinlock> lock(*m_mutex);
+
+        state->m_next       = m_threads;
+
+        if (m_threads != nullptr)
+            m_threads->m_prev = state;
+
+        m_threads           = state;
+    };
+
+    mutator_thread::value   = state;
+    g_state_owner.m_state   = state;
+
+    return state;
+};
+
+void mutator_lock::unregister_thread(mutator_state* state)
+{
+    {
+        std::lock_guard<spinlock> lock(*m_mutex);
+
+        if (state->m_prev != nullptr)
+            state->m_prev->m_next   = state->m_next;
+        else
+            m_threads               = state->m_next;
+
+        if (state->m_next != nullptr)
+            state->m_next->m_prev   = state->m_prev;
+
+        // these roots will be processed during next collection
+        for (size_t i = 0; i < max_domains; ++i)
+            append_roots(m_orphan_roots[i], state->m_roots[i]);
+    };
+
+    mutator_thread::value   = nullptr;
+    delete state;
+};
+
+void mutator_lock::process_memory_barrier()
+{
+    #ifdef _WIN32
+        FlushProcessWriteBuffers();
+    #else
+        static bool registered  = syscall(__NR_membarrier, 
+                                    MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+
+        if (registered == true)
+            syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+        else
+            syscall(__NR_membarrier, MEMBARRIER_CMD_SHARED, 0);
+    #endif
+};
+
+void mutator_lock::stop_mutators(size_t domain)
+{
+    m_stopped[domain].fetch_add(1, std::memory_order_seq_cst);
+
+    // make all m_active flags set before m_stopped was stored visible
+    process_memory_barrier();
+
+    std::lock_guard<spinlock> lock(*m_mutex);
+
+    // mutators updating objects from other domains are not waited for
+    int active  = (int)domain + 1;
+
+    for (mutator_state* state = m_threads; state != nullptr; state = state->m_next)
+    {
+        while (state->m_active.load(std::memory_order_acquire) == active)
+            std::this_thread::yield();
+    };
+};
+
+void mutator_lock::resume_mutators(size_t domain)
+{
+    m_stopped[domain].fetch_sub(1, std::memory_order_release);
+};
+
+void mutator_lock::append_roots(root_vector& roots, root_vector& buffer)
+{
+    roots.insert(roots.end(), buffer.begin(), buffer.end());
+    buffer.clear();
+};
+
+void mutator_lock::append_roots(root_buffer& roots, root_vector& buffer)
+{
+    roots.append(buffer);
+    buffer.clear();
+};
+
+void mutator_lock::flush_roots(size_t domain, root_buffer& roots)
+{
+    mutator_state* state = mutator_thread::value;
+
+    if (state != nullptr)
+        append_roots(roots, state->m_roots[domain]);
+};
+
+void mutator_lock::flush_all_roots(size_t domain, root_buffer& roots)
+{
+    std::lock_guard<spinlock> lock(*m_mutex);
+
+    for (mutator_state* state = m_threads; state != nullptr; state = state->m_next)
+        append_roots(roots, state->m_roots[domain]);
+
+    append_roots(roots, m_orphan_roots[domain]);
+};
+
+//------------------------------------------------------------
+//                      striped_lock
+//------------------------------------------------------------
+striped_lock::stripe striped_lock::m_stripes[max_domains][striped_lock::n_stripes];
+int striped_lock::m_stopped[max_domains]    = {};
+std::atomic<size_t> striped_lock::m_next_index(0);
+
+thread_local
+size_t striped_thread::index                = 0;
+
+thread_local
+boost::detail::spinlock* striped_thread::entered    = nullptr;
+
+void striped_lock::stop_mutators(size_t domain)
+{
+    // mutators hold at most one stripe, and stripes of a domain are locked
+    // only by the holder of the global lock, therefore the order of locking
+    // is not important
+    if (m_stopped[domain]++ != 0)
+        return;
+
+    for (size_t i = 0; i < n_stripes; ++i)
+        m_stripes[domain][i].m_mutex.lock();
+};
+
+void striped_lock::resume_mutators(size_t domain)
+{
+    if (--m_stopped[domain] != 0)
+        return;
+
+    for (size_t i = 0; i < n_stripes; ++i)
+        m_stripes[domain][i].m_mutex.unlock();
+};
+
+void striped_lock::append_roots(root_buffer& roots, stripe& s)
+{
+    if (s.m_roots == nullptr)
+        return;
+
+    roots.append(*s.m_roots);
+    s.m_roots->clear();
+};
+
+void striped_lock::flush_roots(size_t domain, root_buffer& roots)
+{
+    // stripes are already locked by this thread, if mutators are stopped
+    stripe& s   = get_stripe(domain);
+
+    if (m_stopped[domain] != 0)
+        return append_roots(roots, s);
+
+    std::lock_guard<mutex_type> lock(s.m_mutex);
+    append_roots(roots, s);
+};
+
+void striped_lock::flush_all_roots(size_t domain, root_buffer& roots)
+{
+    for (size_t i = 0; i < n_stripes; ++i)
+        append_roots(roots, m_stripes[domain][i]);
+};
+
+void striped_lock::close()
+{
+    for (size_t i = 0; i < max_domains; ++i)
+    {
+        for (size_t j = 0; j < n_stripes; ++j)
+        {
+            delete m_stripes[i][j].m_roots;
+            m_stripes[i][j].m_roots = nullptr;
+        };
+    };
+};
+
+}};
@@ -0,0 +1,129 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "cyclic_rc/details/object_pool.h"
+#include "cyclic_rc/details/obj_count.h"
+
+#include <mutex>
+#include <algorithm>
+#include <functional>
+#include <boost/pool/pool.hpp>
+
+namespace cyclic_rc { namespace details
+{
+
+//------------------------------------------------------------
+//                      object_pool
+//------------------------------------------------------------
+
+template<bool multithread>
+struct pool_mutex
+{
+    using type  = spinlock;
+};
+
+template<>
+struct pool_mutex<false>
+{
+    using type  = nomutex;
+};
+
+// blocks of one size
+template<bool multithread>
+struct size_class_pool
+{
+    using mutex_type    = typename pool_mutex<multithread>::type;
+
+    boost::pool<>       m_pool;
+    mutex_type          m_mutex;
+
+    size_class_pool(size_t size)
+        : m_pool(size)
+    {};
+};
+
+// pools are created on first use and never destroyed
+template<bool multithread>
+static size_class_pool<multithread>& get_pool(size_t size_class)
+{
+    using pool_type     = size_class_pool<multithread>;
+    using object_pool   = object_pool<multithread>;
+
+    struct pool_table
+    {
+        pool_type*      m_pools[object_pool::n_classes];
+
+        pool_table()
+        {
+            for (size_t i = 0; i < object_pool::n_classes; ++i)
+                m_pools[i] = new pool_type((i + 1) * object_pool::size_step);
+        };
+    };
+
+    static pool_table* table    = new pool_table();
+    return *table->m_pools[size_class];
+};
+
+template<bool multithread>
+void* object_pool<multithread>::allocate(size_t size_class)
+{
+    auto& pool      = get_pool<multithread>(size_class);
+    void* ptr;
+
+    {
+        std::lock_guard<typename size_class_pool<multithread>::mutex_type> lock(pool.m_mutex);
+        ptr         = pool.m_pool.malloc();
+    };
+
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+
+    return ptr;
+};
+
+template<bool multithread>
+void object_pool<multithread>::deallocate(size_t size_class, void* ptr)
+{
+    auto& pool      = get_pool<multithread>(size_class);
+
+    std::lock_guard<typename size_class_pool<multithread>::mutex_type> lock(pool.m_mutex);
+    pool.m_pool.free(ptr);
+};
+
+template<bool multithread>
+void object_pool<multithread>::deallocate(size_t size_class, void** ptrs, size_t n)
+{
+    auto& pool      = get_pool<multithread>(size_class);
+
+    // free blocks are reused in reverse order; after sorting next 
+    // allocations return blocks with increasing addresses, as in a new pool
+    std::sort(ptrs, ptrs + n, std::greater<void*>());
+
+    std::lock_guard<typename size_class_pool<multithread>::mutex_type> lock(pool.m_mutex);
+
+    for (size_t i = 0; i < n; ++i)
+        pool.m_pool.free(ptrs[i]);
+};
+
+template object_pool<false>;
+template object_pool<true>;
+
+}}
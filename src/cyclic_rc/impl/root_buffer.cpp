@@ -0,0 +1,120 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "cyclic_rc/details/root_buffer.h"
+#include "cyclic_rc/details/obj_count.h"
+
+#include <mutex>
+#include <cstdlib>
+#include <new>
+
+namespace cyclic_rc { namespace details
+{
+
+//------------------------------------------------------------
+//                      root_chunk_pool
+//------------------------------------------------------------
+namespace
+{
+
+// released chunks form a list linked through the first word of a chunk
+struct free_chunk
+{
+    free_chunk*         m_next;
+};
+
+// root buffers of all collectors share one pool; the pool is created on 
+// first use and never destroyed, therefore chunks can be released during 
+// destruction of global objects
+struct chunk_list
+{
+    spinlock            m_mutex;
+    free_chunk*         m_head;
+    size_t              m_size;
+
+    chunk_list()
+        : m_head(nullptr), m_size(0)
+    {};
+};
+
+chunk_list& get_chunk_list()
+{
+    static chunk_list* list = new chunk_list();
+    return *list;
+};
+
+}
+
+void* root_chunk_pool::allocate()
+{
+    chunk_list& list    = get_chunk_list();
+
+    {
+        std::lock_guard<spinlock> lock(list.m_mutex);
+
+        if (list.m_head != nullptr)
+        {
+            free_chunk* chunk   = list.m_head;
+            list.m_head         = chunk->m_next;
+            --list.m_size;
+
+            return chunk;
+        };
+    };
+
+    void* chunk         = std::malloc(chunk_bytes);
+
+    if (chunk == nullptr)
+        throw std::bad_alloc();
+
+    return chunk;
+};
+
+void root_chunk_pool::deallocate(void* ptr)
+{
+    chunk_list& list    = get_chunk_list();
+
+    {
+        std::lock_guard<spinlock> lock(list.m_mutex);
+
+        if (list.m_size < max_cached_chunks)
+        {
+            free_chunk* chunk   = static_cast<free_chunk*>(ptr);
+            chunk->m_next       = list.m_head;
+            list.m_head         = chunk;
+            ++list.m_size;
+
+            return;
+        };
+    };
+
+    std::free(ptr);
+};
+
+size_t root_chunk_pool::cached_chunks()
+{
+    chunk_list& list    = get_chunk_list();
+
+    std::lock_guard<spinlock> lock(list.m_mutex);
+    return list.m_size;
+};
+
+}}
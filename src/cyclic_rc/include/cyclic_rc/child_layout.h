@@ -0,0 +1,122 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/shared_ptr.h"
+
+#include <initializer_list>
+#include <vector>
+
+namespace cyclic_rc
+{
+
+// function visiting a shared_ptr member (or a container of shared_ptr) of
+// a managed object; the member is given by a template argument
+struct child_entry
+{
+    using visit_func    = void (*)(void* object, int type);
+
+    visit_func      visit;
+};
+
+// table of children of a managed object; members are visited in the order
+// of entries
+class child_layout
+{
+    private:
+        using entry_vector  = std::vector<child_entry>;
+
+    public:
+        using const_iterator    = entry_vector::const_iterator;
+
+    private:
+        entry_vector        m_entries;
+
+    public:
+        child_layout(std::initializer_list<child_entry> entries);
+
+        const_iterator      begin() const   { return m_entries.begin(); };
+        const_iterator      end() const     { return m_entries.end(); };
+};
+
+// base class of objects, that describe their children by a table instead
+// of implementing visit_children; Derived must provide a function
+//
+//      static const child_layout& get_layout();
+//
+// returning entries created by CYCLIC_RC_CHILD (for shared_ptr members)
+// and CYCLIC_RC_CHILDREN (for members, that are containers of shared_ptr
+// objects, i.e. support range-based for loop), for example:
+//
+//      static const child_layout& get_layout()
+//      {
+//          static const child_layout layout = 
+//          {
+//              CYCLIC_RC_CHILD(node, left),
+//              CYCLIC_RC_CHILD(node, right),
+//              CYCLIC_RC_CHILDREN(node, items)
+//          };
+//          return layout;
+//      };
+//
+// Members are accessed through pointers to members of Derived applied to
+// static_cast<Derived*>(this), not through offsets, therefore Derived can 
+// be polymorphic; listed members must be declared in Derived. Entries 
+// should be listed in the order of declaration of members. Children are 
+// visited by one loop over the table; the table is shared by all objects of
+// type Derived.
+template<class Derived, bool multithread>
+class layout_rc_base : public cyclic_rc_base<multithread>
+{
+    public:
+        // initialize reference counter to zero; see cyclic_rc_base
+        layout_rc_base(bool is_acyclic = false);
+
+        // visit all members listed in Derived::get_layout()
+        virtual void        visit_children(int type) override final;
+};
+
+namespace details
+{
+
+template<class T, class Ptr, Ptr T::* member>
+void visit_child_member(void* object, int type);
+
+template<class T, class Container, Container T::* member>
+void visit_child_range(void* object, int type);
+
+};
+
+};
+
+// entry of a child_layout describing shared_ptr member of class type
+#define CYCLIC_RC_CHILD(type, member)                                       \
+    cyclic_rc::child_entry{&cyclic_rc::details::visit_child_member          \
+        <type, decltype(type::member), &type::member>}
+
+// entry of a child_layout describing a container of shared_ptr objects 
+// being a member of class type
+#define CYCLIC_RC_CHILDREN(type, member)                                    \
+    cyclic_rc::child_entry{&cyclic_rc::details::visit_child_range           \
+        <type, decltype(type::member), &type::member>}
+
+#include "cyclic_rc/details/child_layout.inl"
@@ -0,0 +1,113 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+
+#pragma once
+
+#include "cyclic_rc/shared_ptr.h"
+
+#include <chrono>
+
+namespace cyclic_rc
+{
+
+// independent collector of multithreaded objects
+//
+// Each domain has its own global lock, buffers of possible roots, 
+// thresholds, background collector and free threads; collection in one 
+// domain never stops threads working with objects of other domains. 
+// Objects with multithread = true are assigned to the domain current for
+// the thread creating them; by default this is the domain 0 controlled by
+// static functions of shared_ptr; the current domain is changed by 
+// collector_domain::scope. Objects with multithread = false always belong
+// to the domain 0.
+//
+// Objects from different domains cannot reference each other. All objects
+// of a domain must be released before the domain is destroyed; remaining 
+// garbage cycles are collected by the destructor. At most max_domains - 1 
+// domains can exist at the same time; index of the domain is stored in the
+// counter word of an object, therefore on 32-bit builds max_domains = 1 and
+// only the domain 0 exists.
+class collector_domain
+{
+    private:
+        using config        = details::config_thread;
+        using obj_count     = details::obj_count<config>;
+
+    public:
+        // maximum number of domains including the domain 0
+        static const size_t max_domains = details::max_domains;
+
+    public:
+        // makes given domain current for the calling thread until the scope
+        // is destroyed
+        class scope
+        {
+            public:
+                explicit scope(const collector_domain& domain);
+                ~scope();
+
+                scope(const scope&) = delete;
+                scope& operator=(const scope&) = delete;
+
+            private:
+                size_t      m_saved;
+        };
+
+    public:
+        // create new domain; throw std::length_error if max_domains domains
+        // already exist
+        collector_domain();
+
+        // collect garbage and destroy the domain
+        ~collector_domain();
+
+        collector_domain(const collector_domain&) = delete;
+        collector_domain& operator=(const collector_domain&) = delete;
+
+        // index of this domain
+        size_t              id() const;
+
+        // functions equivalent to static functions of shared_ptr<T, true> 
+        // applied to this domain
+        void                collect(bool all);
+        bool                collect_step(size_t max_roots);
+        bool                collect_step(std::chrono::microseconds max_time);
+        void                start_background_collector();
+        void                stop_background_collector();
+        void                set_concurrent_collector(bool concurrent);
+        void                set_collection_threshold(size_t min_threshold, 
+                                size_t max_threshold);
+        size_t              get_collection_threshold() const;
+        void                set_memory_threshold(size_t bytes);
+        void                set_prefetch_distance(size_t distance);
+        void                set_root_snapshot(bool snapshot);
+        collector_stats     get_stats() const;
+        void                set_collector_threads(size_t n_threads);
+        void                set_free_threads(size_t n_threads);
+
+    private:
+        size_t              m_index;
+};
+
+};
+
+#include "cyclic_rc/details/collector_domain.inl"
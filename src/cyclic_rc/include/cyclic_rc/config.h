@@ -34,4 +34,58 @@
     #define CYCLIC_RC_EXPORT _declspec(dllimport)
 #endif
 
-#define CYCLIC_RC_FORCE_INLINE __forceinline
\ No newline at end of file
+#define CYCLIC_RC_FORCE_INLINE __forceinline
+
+// hint, that memory at ptr will be accessed soon; no-op on architectures 
+// without a known prefetch instruction
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+    #include <xmmintrin.h>
+    #define CYCLIC_RC_PREFETCH(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
+#elif defined(__GNUC__)
+    #define CYCLIC_RC_PREFETCH(ptr) __builtin_prefetch((const void*)(ptr))
+#else
+    #define CYCLIC_RC_PREFETCH(ptr) ((void)(ptr))
+#endif
+
+// number of bits of the counter word storing index of the collector domain 
+// of an object (see collector_domain.h); bits are taken from the reference
+// count, therefore domains are available only on 64-bit builds, 32-bit 
+// builds have only the default domain
+#include <cstdint>
+
+#if SIZE_MAX > 0xFFFFFFFFu
+    #define CYCLIC_RC_DOMAIN_BITS   8
+#else
+    #define CYCLIC_RC_DOMAIN_BITS   0
+#endif
+
+// synchronization of reference counters used by multithreaded shared_ptr:
+//  CYCLIC_RC_MT_LOCKED     - every counter update is protected by a single
+//                            global lock
+//  CYCLIC_RC_MT_LOCK_FREE  - counters are updated using atomic operations;
+//                            global lock is taken only when an object must be
+//                            buffered as possible root, released or collected
+//  CYCLIC_RC_MT_BIASED     - as CYCLIC_RC_MT_LOCK_FREE, but references created
+//                            by the thread, that created an object, are 
+//                            counted without atomic operations; objects 
+//                            released by other threads are more expensive
+//  CYCLIC_RC_MT_STRIPED    - counters are updated under one of 
+//                            CYCLIC_RC_MT_STRIPES locks selected by the 
+//                            address of the object; a thread updating 
+//                            counters holds one of CYCLIC_RC_MT_STRIPES locks
+//                            of the domain instead of the global lock, the 
+//                            collector stops threads by taking all of them
+#define CYCLIC_RC_MT_LOCKED     0
+#define CYCLIC_RC_MT_LOCK_FREE  1
+#define CYCLIC_RC_MT_BIASED     2
+#define CYCLIC_RC_MT_STRIPED    3
+
+#ifndef CYCLIC_RC_MT_MODE
+    #define CYCLIC_RC_MT_MODE   CYCLIC_RC_MT_LOCK_FREE
+#endif
+
+// number of locks protecting counters and number of locks of a domain taken
+// by threads in CYCLIC_RC_MT_STRIPED mode; must be a power of 2
+#ifndef CYCLIC_RC_MT_STRIPES
+    #define CYCLIC_RC_MT_STRIPES    64
+#endif
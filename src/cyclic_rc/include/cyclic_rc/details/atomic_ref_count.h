@@ -0,0 +1,174 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#pragma once
+
+#include "cyclic_rc/details/ref_count.h"
+
+#include <atomic>
+
+namespace cyclic_rc { namespace details
+{
+
+// version of rc_count, that can be modified concurrently by many threads;
+// count, color, buffered flag and age are stored in one word; functions
+// increase_count_black, try_decrease_count, decrease_count_purple and 
+// functions used by parallel collection are implemented using atomic 
+// operations and can be called concurrently; other
+// functions modifying this object require exclusive access, i.e. can be
+// called by the collector, when mutators are stopped, or when reference 
+// count is zero
+class atomic_rc_count
+{
+    public:
+        atomic_rc_count(bool is_acyclic, size_t domain = 0);
+
+        size_t              get_count() const;
+        size_t              get_domain() const;
+
+        bool                is_count_zero() const;
+        bool                is_acyclic() const;
+        bool                is_purple() const;
+        bool                is_black() const;
+        bool                is_gray() const;
+        bool                is_white() const;
+        bool                is_yellow() const;
+        bool                is_buffered() const;
+        bool                is_young() const;
+        bool                is_medium() const;
+        bool                is_old() const;
+
+        void                increase_count();
+        size_t              decrease_count();
+
+        // increase count and mark this object as black; acyclic objects
+        // remain green
+        void                increase_count_black();
+
+        // increase and decrease count of an acyclic object without changing
+        // color; decrease_count_acyclic returns new count
+        void                increase_count_acyclic();
+        size_t              decrease_count_acyclic();
+
+        // decrease count if it does not drop to zero, otherwise return false;
+        // this object is marked in the same way as in decrease_count_purple
+        bool                try_decrease_count(bool& add_young);
+
+        // decrease count; if count does not drop to zero and this object is
+        // not acyclic, then mark it as purple; if additionally this object
+        // is not stored in the young buffer, then mark it as buffered young
+        // object and set add_young to true; return new count
+        size_t              decrease_count_purple(bool& add_young);
+
+        void                mark_black();
+        void                mark_gray();
+        void                mark_white();
+        void                mark_purple();
+        void                mark_yellow();
+        void                mark_buffered();
+        void                mark_nonbuffered();
+        void                mark_age(age_type age);
+
+        // functions used by parallel collection; in atomic_rc_count these 
+        // functions can be called concurrently by collector threads, when 
+        // mutators are stopped
+
+        // mark as gray; return false if already gray
+        bool                try_mark_gray();
+
+        // if gray, mark as black if count is nonzero, or as white otherwise;
+        // return false if not gray; is_black is set to true if marked as black
+        bool                try_scan(bool& is_black);
+
+        // increase count and mark as black; return false if already black
+        bool                increase_count_scan_black();
+
+        // change white color to black; return false if not white
+        bool                try_collect_white();
+
+        void                decrease_count_parallel();
+
+        // functions used by biased_rc_count
+
+        // mark this object in the same way as decrease_count_purple when
+        // count does not drop to zero, but do not change count
+        void                mark_purple_root(bool& add_young);
+
+        // increase count by n; requires exclusive access
+        void                increase_count(size_t n);
+
+        // decrease count if nonzero, otherwise return false; can be called
+        // concurrently by collector threads
+        bool                try_decrease_count_parallel();
+
+        // version of try_scan, where extra references counted outside this
+        // object are added to count
+        bool                try_scan(bool& is_black, size_t extra);
+
+    private:
+        enum class color
+        {
+            black   = 0,    // in use or free
+            green   = 1,    // acyclic
+            gray    = 2,    // possible member of cycle
+            white   = 3,    // member of garbage cycle
+            purple  = 4,    // possible root of cycle
+            yellow  = 5,    // destroyed
+        };
+
+        // layout of the counter word; the same as rc_count::ref_info
+        // domain_shift is reduced modulo word_bits, otherwise shifts would be
+        // invalid if domain_bits = 0
+        static const size_t word_bits       = sizeof(size_t) * 8;
+        static const size_t count_bits      = details::count_bits;
+        static const size_t color_shift     = count_bits;
+        static const size_t buffered_shift  = count_bits + 3;
+        static const size_t age_shift       = count_bits + 4;
+        static const size_t domain_shift    = (count_bits + 6) % word_bits;
+
+        static const size_t count_mask      = (size_t(1) << count_bits) - 1;
+        static const size_t color_mask      = size_t(7) << color_shift;
+        static const size_t buffered_mask   = size_t(1) << buffered_shift;
+        static const size_t age_mask        = size_t(3) << age_shift;
+
+        using word_type     = std::atomic<size_t>;
+
+    private:
+        size_t              load() const;
+        void                store(size_t word);
+        size_t              get_color() const;
+        size_t              get_age() const;
+        void                set_color(color c);
+
+        // try to change color of the word old; on failure old is set to 
+        // current value
+        bool                try_change_color(size_t& old, color c);
+
+        static size_t       get_color(size_t word);
+        static size_t       get_age(size_t word);
+        static size_t       make_color(color c);
+
+    private:
+        word_type           m_word;
+};
+
+};};
+
+#include "atomic_ref_count.inl"
@@ -0,0 +1,434 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#pragma once
+
+#include "atomic_ref_count.h"
+#include <cassert>
+
+namespace cyclic_rc { namespace details
+{
+
+inline atomic_rc_count::atomic_rc_count(bool is_acyclic, size_t domain)
+    : m_word(((size_t)age_type::old << age_shift)
+            | make_color(is_acyclic ? color::green : color::black)
+            | (domain << domain_shift))
+{
+    assert(domain < max_domains);
+};
+
+inline size_t atomic_rc_count::load() const
+{
+    return m_word.load(std::memory_order_acquire);
+};
+
+inline void atomic_rc_count::store(size_t word)
+{
+    m_word.store(word, std::memory_order_relaxed);
+};
+
+inline size_t atomic_rc_count::get_color(size_t word)
+{
+    return (word & color_mask) >> color_shift;
+};
+
+inline size_t atomic_rc_count::get_age(size_t word)
+{
+    return (word & age_mask) >> age_shift;
+};
+
+inline size_t atomic_rc_count::make_color(color c)
+{
+    return (size_t)c << color_shift;
+};
+
+inline size_t atomic_rc_count::get_color() const
+{
+    return get_color(load());
+};
+
+inline size_t atomic_rc_count::get_age() const
+{
+    return get_age(load());
+};
+
+inline size_t atomic_rc_count::get_count() const
+{
+    return load() & count_mask;
+}
+
+inline size_t atomic_rc_count::get_domain() const
+{
+    // domain is never changed
+    if (domain_bits == 0)
+        return 0;
+
+    return m_word.load(std::memory_order_relaxed) >> domain_shift;
+}
+
+inline bool atomic_rc_count::is_count_zero() const
+{
+    return get_count() == 0;
+};
+
+inline bool atomic_rc_count::is_acyclic() const
+{
+    return get_color() == (size_t)color::green;
+};
+
+inline bool atomic_rc_count::is_purple() const
+{
+    return get_color() == (size_t)color::purple;
+};
+
+inline bool atomic_rc_count::is_black() const
+{
+    return get_color() == (size_t)color::black;
+};
+
+inline bool atomic_rc_count::is_gray() const
+{
+    return get_color() == (size_t)color::gray;
+};
+
+inline bool atomic_rc_count::is_white() const
+{
+    return get_color() == (size_t)color::white;
+};
+
+inline bool atomic_rc_count::is_yellow() const
+{
+    return get_color() == (size_t)color::yellow;
+};
+
+inline bool atomic_rc_count::is_buffered() const
+{
+    return (load() & buffered_mask) != 0;
+};
+
+inline bool atomic_rc_count::is_young() const
+{
+    return get_age() == (size_t)age_type::young;
+};
+
+inline bool atomic_rc_count::is_medium() const
+{
+    return get_age() == (size_t)age_type::medium;
+};
+
+inline bool atomic_rc_count::is_old() const
+{
+    return get_age() == (size_t)age_type::old;
+};
+
+inline void atomic_rc_count::increase_count()
+{
+    assert((load() & count_mask) < count_mask && "reference count overflow");
+    store(load() + 1);
+};
+
+inline size_t atomic_rc_count::decrease_count()
+{
+    size_t old = load();
+
+    assert((old & count_mask) > 0);
+
+    store(old - 1);
+    return (old & count_mask) - 1;
+};
+
+inline void atomic_rc_count::increase_count_black()
+{
+    size_t old = m_word.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    assert((old & count_mask) != 0 && "reference count overflow");
+
+    while (get_color(old) != (size_t)color::black 
+           && get_color(old) != (size_t)color::green)
+    {
+        size_t word = (old & ~color_mask) | make_color(color::black);
+
+        if (m_word.compare_exchange_weak(old, word, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed) == true)
+        {
+            return;
+        };
+    };
+};
+
+inline void atomic_rc_count::increase_count_acyclic()
+{
+    size_t old = m_word.fetch_add(1, std::memory_order_relaxed);
+
+    (void)old;
+    assert((old & count_mask) < count_mask && "reference count overflow");
+};
+
+inline size_t atomic_rc_count::decrease_count_acyclic()
+{
+    size_t old = m_word.fetch_sub(1, std::memory_order_acq_rel);
+
+    assert((old & count_mask) > 0);
+    return (old & count_mask) - 1;
+};
+
+inline bool atomic_rc_count::try_decrease_count(bool& add_young)
+{
+    size_t old = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        add_young   = false;
+
+        if ((old & count_mask) <= 1)
+            return false;
+
+        size_t col  = get_color(old);
+        size_t word = old - 1;
+
+        if (col != (size_t)color::green && col != (size_t)color::purple)
+        {
+            word    = (word & ~color_mask) | make_color(color::purple);
+
+            if (get_age(old) != (size_t)age_type::young)
+            {
+                word        = (word & ~age_mask) | buffered_mask
+                            | ((size_t)age_type::young << age_shift);
+                add_young   = true;
+            };
+        };
+
+        if (m_word.compare_exchange_weak(old, word, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed) == true)
+        {
+            return true;
+        };
+    };
+};
+
+inline size_t atomic_rc_count::decrease_count_purple(bool& add_young)
+{
+    size_t old = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        assert((old & count_mask) > 0);
+
+        size_t word = old - 1;
+        size_t col  = get_color(old);
+        add_young   = false;
+
+        if ((word & count_mask) != 0 && col != (size_t)color::green 
+            && col != (size_t)color::purple)
+        {
+            word    = (word & ~color_mask) | make_color(color::purple);
+
+            if (get_age(old) != (size_t)age_type::young)
+            {
+                word        = (word & ~age_mask) | buffered_mask
+                            | ((size_t)age_type::young << age_shift);
+                add_young   = true;
+            };
+        };
+
+        if (m_word.compare_exchange_weak(old, word, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed) == true)
+        {
+            return word & count_mask;
+        };
+    };
+};
+
+inline void atomic_rc_count::set_color(color c)
+{
+    store((load() & ~color_mask) | make_color(c));
+};
+
+inline void atomic_rc_count::mark_black()
+{
+    set_color(color::black);
+};
+
+inline void atomic_rc_count::mark_gray()
+{
+    set_color(color::gray);
+}
+
+inline void atomic_rc_count::mark_white()
+{
+    set_color(color::white);
+};
+
+inline void atomic_rc_count::mark_purple()
+{
+    set_color(color::purple);
+};
+
+inline void atomic_rc_count::mark_yellow()
+{
+    set_color(color::yellow);
+};
+
+inline void atomic_rc_count::mark_buffered()
+{
+    store(load() | buffered_mask);
+};
+
+inline void atomic_rc_count::mark_nonbuffered()
+{
+    store(load() & ~buffered_mask);
+};
+
+inline void atomic_rc_count::mark_age(age_type age)
+{
+    store((load() & ~age_mask) | ((size_t)age << age_shift));
+};
+
+inline bool atomic_rc_count::try_change_color(size_t& old, color c)
+{
+    size_t word = (old & ~color_mask) | make_color(c);
+
+    return m_word.compare_exchange_weak(old, word, std::memory_order_acq_rel,
+                                        std::memory_order_relaxed);
+};
+
+inline bool atomic_rc_count::try_mark_gray()
+{
+    size_t old  = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        if (get_color(old) == (size_t)color::gray)
+            return false;
+
+        if (try_change_color(old, color::gray) == true)
+            return true;
+    };
+};
+
+inline bool atomic_rc_count::try_scan(bool& is_black)
+{
+    return try_scan(is_black, 0);
+};
+
+inline bool atomic_rc_count::try_scan(bool& is_black, size_t extra)
+{
+    size_t old  = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        // color can be changed by scan_black called by other thread
+        if (get_color(old) != (size_t)color::gray)
+            return false;
+
+        is_black    = (old & count_mask) + extra != 0;
+
+        if (try_change_color(old, is_black ? color::black : color::white) == true)
+            return true;
+    };
+};
+
+inline bool atomic_rc_count::increase_count_scan_black()
+{
+    size_t old  = m_word.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    for (;;)
+    {
+        if (get_color(old) == (size_t)color::black)
+            return false;
+
+        if (try_change_color(old, color::black) == true)
+            return true;
+    };
+};
+
+inline bool atomic_rc_count::try_collect_white()
+{
+    size_t old  = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        if (get_color(old) != (size_t)color::white)
+            return false;
+
+        if (try_change_color(old, color::black) == true)
+            return true;
+    };
+};
+
+inline void atomic_rc_count::decrease_count_parallel()
+{
+    m_word.fetch_sub(1, std::memory_order_acq_rel);
+};
+
+inline void atomic_rc_count::mark_purple_root(bool& add_young)
+{
+    size_t old = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        add_young   = false;
+        size_t col  = get_color(old);
+
+        if (col == (size_t)color::green || col == (size_t)color::purple)
+            return;
+
+        size_t word = (old & ~color_mask) | make_color(color::purple);
+
+        if (get_age(old) != (size_t)age_type::young)
+        {
+            word        = (word & ~age_mask) | buffered_mask
+                        | ((size_t)age_type::young << age_shift);
+            add_young   = true;
+        };
+
+        if (m_word.compare_exchange_weak(old, word, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed) == true)
+        {
+            return;
+        };
+    };
+};
+
+inline void atomic_rc_count::increase_count(size_t n)
+{
+    assert((load() & count_mask) + n <= count_mask);
+
+    store(load() + n);
+};
+
+inline bool atomic_rc_count::try_decrease_count_parallel()
+{
+    size_t old  = m_word.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        if ((old & count_mask) == 0)
+            return false;
+
+        if (m_word.compare_exchange_weak(old, old - 1, std::memory_order_acq_rel,
+                                         std::memory_order_relaxed) == true)
+        {
+            return true;
+        };
+    };
+};
+
+}}
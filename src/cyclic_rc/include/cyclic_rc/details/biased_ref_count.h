@@ -0,0 +1,133 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/details/atomic_ref_count.h"
+#include "cyclic_rc/details/mutator_lock.h"
+
+#include <atomic>
+
+namespace cyclic_rc { namespace details
+{
+
+// version of atomic_rc_count optimized for objects used mainly by the 
+// thread, that created them (biased reference counting); references created
+// by the owner thread are counted in a separate biased counter, which is
+// modified only by the owner without atomic read-modify-write operations;
+// references created by other threads, color, buffered flag and age are 
+// stored in atomic_rc_count; the reference count is the sum of both 
+// counters; when another thread must remove a reference counted by the 
+// owner, then mutators are stopped, the biased counter is merged into the
+// shared counter and the object is no longer owned by any thread; acyclic 
+// objects are not owned; functions requiring exclusive access and functions
+// used by parallel collection have the same meaning as in atomic_rc_count
+class biased_rc_count
+{
+    public:
+        biased_rc_count(bool is_acyclic, size_t domain = 0);
+
+        size_t              get_count() const;
+        size_t              get_domain() const;
+
+        bool                is_count_zero() const;
+        bool                is_acyclic() const;
+        bool                is_purple() const;
+        bool                is_black() const;
+        bool                is_gray() const;
+        bool                is_white() const;
+        bool                is_yellow() const;
+        bool                is_buffered() const;
+        bool                is_young() const;
+        bool                is_medium() const;
+        bool                is_old() const;
+
+        void                increase_count();
+        size_t              decrease_count();
+
+        // increase count and mark this object as black; acyclic objects
+        // remain green; increments made by the owner do not change color, 
+        // purple object remains a possible root
+        void                increase_count_black();
+
+        // increase and decrease count of an acyclic object without changing
+        // color; decrease_count_acyclic returns new count
+        void                increase_count_acyclic();
+        size_t              decrease_count_acyclic();
+
+        // decrease count if it does not drop to zero, otherwise return false;
+        // this object is marked in the same way as in decrease_count_purple;
+        // must be called inside lock-free section
+        bool                try_decrease_count(bool& add_young);
+
+        // decrease count; if count does not drop to zero and this object is
+        // not acyclic, then mark it as purple; if additionally this object
+        // is not stored in the young buffer, then mark it as buffered young
+        // object and set add_young to true; return new count; global lock 
+        // must be held
+        size_t              decrease_count_purple(bool& add_young);
+
+        void                mark_black();
+        void                mark_gray();
+        void                mark_white();
+        void                mark_purple();
+        void                mark_yellow();
+        void                mark_buffered();
+        void                mark_nonbuffered();
+        void                mark_age(age_type age);
+
+        // functions used by parallel collection
+
+        // mark as gray; return false if already gray
+        bool                try_mark_gray();
+
+        // if gray, mark as black if count is nonzero, or as white otherwise;
+        // return false if not gray; is_black is set to true if marked as black
+        bool                try_scan(bool& is_black);
+
+        // increase count and mark as black; return false if already black
+        bool                increase_count_scan_black();
+
+        // change white color to black; return false if not white
+        bool                try_collect_white();
+
+        void                decrease_count_parallel();
+
+    private:
+        using size_atomic   = std::atomic<size_t>;
+
+    private:
+        bool                is_owner() const;
+        size_t              get_biased() const;
+
+        // move references counted by the owner to the shared counter; the
+        // object is no longer owned; global lock of the domain must be held
+        void                merge();
+
+    private:
+        atomic_rc_count     m_shared;
+        size_atomic         m_biased;
+        mutator_state*      m_owner;
+};
+
+};};
+
+#include "biased_ref_count.inl"
@@ -0,0 +1,286 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "biased_ref_count.h"
+#include <cassert>
+
+namespace cyclic_rc { namespace details
+{
+
+inline biased_rc_count::biased_rc_count(bool is_acyclic, size_t domain)
+    : m_shared(is_acyclic, domain), m_biased(0)
+    , m_owner(is_acyclic ? nullptr : mutator_lock::this_thread())
+{};
+
+inline bool biased_rc_count::is_owner() const
+{
+    return m_owner != nullptr && m_owner == mutator_thread::value;
+};
+
+inline size_t biased_rc_count::get_biased() const
+{
+    return m_biased.load(std::memory_order_acquire);
+};
+
+inline size_t biased_rc_count::get_count() const
+{
+    return m_shared.get_count() + get_biased();
+}
+
+inline size_t biased_rc_count::get_domain() const
+{
+    return m_shared.get_domain();
+}
+
+inline bool biased_rc_count::is_count_zero() const
+{
+    return get_count() == 0;
+};
+
+inline bool biased_rc_count::is_acyclic() const
+{
+    return m_shared.is_acyclic();
+};
+
+inline bool biased_rc_count::is_purple() const
+{
+    return m_shared.is_purple();
+};
+
+inline bool biased_rc_count::is_black() const
+{
+    return m_shared.is_black();
+};
+
+inline bool biased_rc_count::is_gray() const
+{
+    return m_shared.is_gray();
+};
+
+inline bool biased_rc_count::is_white() const
+{
+    return m_shared.is_white();
+};
+
+inline bool biased_rc_count::is_yellow() const
+{
+    return m_shared.is_yellow();
+};
+
+inline bool biased_rc_count::is_buffered() const
+{
+    return m_shared.is_buffered();
+};
+
+inline bool biased_rc_count::is_young() const
+{
+    return m_shared.is_young();
+};
+
+inline bool biased_rc_count::is_medium() const
+{
+    return m_shared.is_medium();
+};
+
+inline bool biased_rc_count::is_old() const
+{
+    return m_shared.is_old();
+};
+
+inline void biased_rc_count::increase_count()
+{
+    m_shared.increase_count();
+};
+
+inline size_t biased_rc_count::decrease_count()
+{
+    if (m_shared.is_count_zero() == false)
+        return m_shared.decrease_count() + get_biased();
+
+    size_t biased = m_biased.load(std::memory_order_relaxed);
+
+    assert(biased > 0);
+
+    m_biased.store(biased - 1, std::memory_order_relaxed);
+    return biased - 1;
+};
+
+inline void biased_rc_count::increase_count_black()
+{
+    if (is_owner() == false)
+        return m_shared.increase_count_black();
+
+    size_t biased = m_biased.load(std::memory_order_relaxed);
+    m_biased.store(biased + 1, std::memory_order_relaxed);
+};
+
+inline void biased_rc_count::increase_count_acyclic()
+{
+    assert(m_owner == nullptr);
+    m_shared.increase_count_acyclic();
+};
+
+inline size_t biased_rc_count::decrease_count_acyclic()
+{
+    assert(m_owner == nullptr);
+    return m_shared.decrease_count_acyclic();
+};
+
+inline bool biased_rc_count::try_decrease_count(bool& add_young)
+{
+    if (is_owner() == true)
+    {
+        size_t biased = m_biased.load(std::memory_order_relaxed);
+
+        // other threads do not decrease the biased counter, therefore count
+        // cannot drop to zero; release order is required, since the object
+        // can be destroyed by other thread
+        if (biased > 1)
+        {
+            m_biased.store(biased - 1, std::memory_order_release);
+            m_shared.mark_purple_root(add_young);
+            return true;
+        };
+    };
+
+    return m_shared.try_decrease_count(add_young);
+};
+
+inline size_t biased_rc_count::decrease_count_purple(bool& add_young)
+{
+    size_t count;
+
+    if (is_owner() == true && m_biased.load(std::memory_order_relaxed) > 0)
+    {
+        size_t biased   = m_biased.load(std::memory_order_relaxed) - 1;
+        m_biased.store(biased, std::memory_order_release);
+
+        // shared counter can be increased only by a thread holding another
+        // reference and is not decreased to zero without the global lock
+        count           = m_shared.get_count() + biased;
+    }
+    else
+    {
+        if (m_shared.is_count_zero() == true)
+            merge();
+
+        // color is changed below
+        count           = m_shared.decrease_count_acyclic() + get_biased();
+    };
+
+    add_young           = false;
+
+    if (count != 0)
+        m_shared.mark_purple_root(add_young);
+
+    return count;
+};
+
+inline void biased_rc_count::merge()
+{
+    // the owner modifies the biased counter only in lock-free sections or
+    // under the global lock; mutators can be already stopped by the 
+    // collector of this domain
+    size_t domain   = m_shared.get_domain();
+
+    mutator_lock::stop_mutators(domain);
+
+    m_shared.increase_count(m_biased.load(std::memory_order_relaxed));
+    m_biased.store(0, std::memory_order_relaxed);
+    m_owner         = nullptr;
+
+    mutator_lock::resume_mutators(domain);
+};
+
+inline void biased_rc_count::mark_black()
+{
+    m_shared.mark_black();
+};
+
+inline void biased_rc_count::mark_gray()
+{
+    m_shared.mark_gray();
+}
+
+inline void biased_rc_count::mark_white()
+{
+    m_shared.mark_white();
+};
+
+inline void biased_rc_count::mark_purple()
+{
+    m_shared.mark_purple();
+};
+
+inline void biased_rc_count::mark_yellow()
+{
+    m_shared.mark_yellow();
+};
+
+inline void biased_rc_count::mark_buffered()
+{
+    m_shared.mark_buffered();
+};
+
+inline void biased_rc_count::mark_nonbuffered()
+{
+    m_shared.mark_nonbuffered();
+};
+
+inline void biased_rc_count::mark_age(age_type age)
+{
+    m_shared.mark_age(age);
+};
+
+inline bool biased_rc_count::try_mark_gray()
+{
+    return m_shared.try_mark_gray();
+};
+
+inline bool biased_rc_count::try_scan(bool& is_black)
+{
+    // biased counter is not modified by scan
+    return m_shared.try_scan(is_black, get_biased());
+};
+
+inline bool biased_rc_count::increase_count_scan_black()
+{
+    return m_shared.increase_count_scan_black();
+};
+
+inline bool biased_rc_count::try_collect_white()
+{
+    return m_shared.try_collect_white();
+};
+
+inline void biased_rc_count::decrease_count_parallel()
+{
+    if (m_shared.try_decrease_count_parallel() == true)
+        return;
+
+    // shared counter is zero and is not increased before all decrements 
+    // are done; count cannot drop below zero
+    m_biased.fetch_sub(1, std::memory_order_acq_rel);
+};
+
+}}
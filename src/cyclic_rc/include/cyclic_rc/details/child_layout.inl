@@ -0,0 +1,67 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/child_layout.h"
+
+namespace cyclic_rc
+{
+
+inline child_layout::child_layout(std::initializer_list<child_entry> entries)
+    :m_entries(entries)
+{};
+
+template<class Derived, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+layout_rc_base<Derived, multithread>::layout_rc_base(bool is_acyclic)
+    :cyclic_rc_base<multithread>(is_acyclic)
+{};
+
+template<class Derived, bool multithread>
+void layout_rc_base<Derived, multithread>::visit_children(int type)
+{
+    const child_layout& layout  = Derived::get_layout();
+    void* object    = static_cast<Derived*>(this);
+
+    for (const child_entry& entry : layout)
+        entry.visit(object, type);
+};
+
+namespace details
+{
+
+template<class T, class Ptr, Ptr T::* member>
+void visit_child_member(void* object, int type)
+{
+    (static_cast<T*>(object)->*member).visit_children(type);
+};
+
+template<class T, class Container, Container T::* member>
+void visit_child_range(void* object, int type)
+{
+    for (auto& ptr : static_cast<T*>(object)->*member)
+        ptr.visit_children(type);
+};
+
+};
+
+};
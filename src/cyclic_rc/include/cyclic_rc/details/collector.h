@@ -22,8 +22,19 @@
 
 #include "cyclic_rc/config.h"
 #include "cyclic_rc/details/ref_count.h"
+#include "cyclic_rc/details/collector_stats.h"
+#include "cyclic_rc/details/work_pool.h"
+#include "cyclic_rc/details/root_buffer.h"
+#include "cyclic_rc/details/local_roots.h"
 
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
 
 #pragma warning(push)
 #pragma warning(disable: 4251) // needs to have dll-interface to be used by clients
@@ -58,6 +69,33 @@ struct collector_is_in_free<config, false>
     static bool value;
 };
 
+// domain of multithreaded objects created by the current thread (see 
+// collector_domain::scope)
+struct current_domain
+{
+    thread_local
+    static size_t value;
+};
+
+// create a collector of multithreaded objects for a new domain; return index
+// of the domain; throw std::length_error if max_domains domains already 
+// exist
+CYCLIC_RC_EXPORT size_t create_domain();
+
+// destroy the collector of given domain created by create_domain; all 
+// objects of the domain must be released
+CYCLIC_RC_EXPORT void   destroy_domain(size_t domain);
+
+// state of a field_ptr shared with the collector; m_log is the position 
+// + 1 of the entry in the log of updates, or 0 if the reference count of 
+// m_object includes this field
+template<bool multithread>
+struct logged_field
+{
+    cyclic_rc_base<multithread>*    m_object;
+    size_t                          m_log;
+};
+
 template<class config>
 class CYCLIC_RC_EXPORT collector
 {
@@ -67,44 +105,402 @@ class CYCLIC_RC_EXPORT collector
 	private:
         using slot_base                 = cyclic_rc_base<multithreaded>;
         using obj_count                 = obj_count<config>;
+        using mutator_lock              = typename config::mutator_lock_type;
+        using mutex_type                = typename config::mutex_type;
         using root_vector               = std::vector<slot_base*>;
+        using time_point                = std::chrono::steady_clock::time_point;
+
+        // buffers of possible roots; memory is drawn from root_chunk_pool
+        // and returned when buffers shrink
+        using root_buffer               = details::root_buffer<slot_base*>;
+
+        // state of an object during concurrent trial deletion
+        enum class crc_color
+        {
+            black, gray, white, member, removed
+        };
+
+        // copy of the reference counter used by concurrent trial deletion;
+        // during validation count is the number of references from other
+        // members of the candidate set
+        struct crc_info
+        {
+            size_t          count;
+            crc_color       color;
+        };
+
+        using crc_table                 = std::unordered_map<slot_base*, crc_info>;
+
+        // state of a buffered root copied by filter_snapshot
+        enum root_state : unsigned char
+        {
+            state_young     = 1,
+            state_buffered  = 2,
+            state_black     = 4,
+            state_zero      = 8,
+        };
+
+        // children of object must be visited with visit_children(type)
+        struct work_item
+        {
+            slot_base*      object;
+            int             type;
+        };
+
+        using work_vector               = std::vector<work_item>;
+        using pool_type                 = work_pool<work_item>;
+
+        // objects [first, last) of the batch freed by free threads
+        struct free_item
+        {
+            size_t          first;
+            size_t          last;
+        };
+
+        using free_pool_type            = work_pool<free_item>;
+        using delete_func               = void (*)(void*);
+        using batch_delete_func         = void (*)(void**, size_t);
+
+        // destroyed objects released by the same deleter; batch_deleter is
+        // called once on all objects if not null
+        struct deleter_group
+        {
+            delete_func         deleter;
+            batch_delete_func   batch_deleter;
+            std::vector<void*>  objects;
+        };
+
+        using deleter_groups            = std::vector<deleter_group>;
+
+        // first modification of a field_ptr since the last reconciliation;
+        // field is null if the field was destroyed
+        struct field_update
+        {
+            logged_field<multithreaded>*    field;
+            slot_base*                      old;
+        };
+
+        using update_vector             = std::vector<field_update>;
 
         static const int n_medium       = 5;
-        static const int threshold      = 2000;
+
+        // collection is started when the number of young objects exceeds
+        // m_threshold; the threshold is doubled after collections, that free
+        // less than one object per grow_ratio processed roots, and halved 
+        // after collections, that free at least one object per processed 
+        // root; the threshold is kept in [m_min_threshold, m_max_threshold]
+        static const size_t default_threshold       = 2000;
+        static const size_t default_min_threshold   = 500;
+        static const size_t default_max_threshold   = 500000;
+        static const size_t grow_ratio              = 4;
+
+        // collection is also started when memory reported by live objects 
+        // (m_allocated_memory) grows by m_memory_threshold since the last 
+        // collection, i.e. reaches m_memory_limit, or when memory of these
+        // objects and of objects added to the young buffer since the last 
+        // collection (m_root_memory) reaches m_memory_limit
+        static const size_t default_memory_threshold = size_t(64) << 20;
+
+        // maximum number of objects released by one call to release; 
+        // remaining objects are released by next calls or by the collector
+        static const size_t release_budget          = 10000;
+
+        // collect_step processes possible roots and releases objects in 
+        // steps of step_roots objects; time limit is checked after each step
+        static const size_t step_roots              = 64;
+
+        // destructors of unreachable objects are called, when number of 
+        // these objects exceeds free_batch
+        static const size_t free_batch              = 1024;
+
+        // minimum number of old roots, when trial deletion is performed by
+        // the thread pool
+        static const size_t parallel_min_roots      = 1000;
+
+        // number of objects in one item processed by free threads
+        static const size_t free_chunk              = 256;
+
+        // maximum capacity of a deleter group kept after objects are freed
+        static const size_t max_deleter_buffer      = 65536;
+
+        // roots are stored in random order; when a buffer of roots is 
+        // processed, counter of a root m_prefetch_distance positions ahead
+        // is prefetched
+        static const size_t default_prefetch_distance = 16;
+
+        // objects in the zero count table are reconciled with local_ptr 
+        // handles, when size of the table exceeds m_deferred_limit; the limit
+        // is at least min_deferred_limit and at least twice the number of 
+        // objects left in the table by the last reconciliation
+        static const size_t min_deferred_limit      = 4096;
+
+        // the log of updates is reconciled, when the number of modified 
+        // fields exceeds update_limit
+        static const size_t update_limit            = 4096;
 
 	private:
-		root_vector*        m_objects_old;
-        root_vector*        m_objects_medium[n_medium];
-        root_vector*        m_objects_young;
+        // index of the domain of this collector and the global lock of the
+        // domain; in single-threaded mode only domain 0 exists
+        size_t              m_domain;
+        mutex_type          m_mutex;
+
+		root_buffer*        m_objects_old;
+        root_buffer*        m_objects_medium[n_medium];
+        root_buffer*        m_objects_young;
         root_vector         m_objects_to_free;
 
+        // possible roots processed by collect_step
+        root_buffer         m_objects_step;
+
+        // objects, whose children are not yet visited by the current phase 
+        // of the collection; used instead of recursion, therefore long chains
+        // of objects cannot overflow the stack
+        work_vector         m_work;
+
+        // objects with zero reference count, whose children are not yet
+        // released
+        root_vector         m_release;
+        bool                m_releasing;
+
+        // parallel trial deletion; m_pool is not null if collector threads 
+        // are set by set_collector_threads
+        pool_type*          m_pool;
+        work_vector         m_parallel_items;
+        std::vector<root_vector>    m_parallel_free;
+
+        // unreachable objects freed by other threads; batches are queued by
+        // queue_free and processed by m_free_thread, that is helped by 
+        // m_free_pool if more than one free thread is set; m_free_mutex 
+        // protects m_free_thread, m_free_queue, m_free_busy and m_free_stop
+        std::thread*        m_free_thread;
+        free_pool_type*     m_free_pool;
+        std::deque<root_vector>     m_free_queue;
+        std::mutex          m_free_mutex;
+        std::condition_variable m_free_cond;
+        bool                m_free_busy;
+        bool                m_free_stop;
+
+        // batch processed by m_free_pool; destructors are called if 
+        // m_free_destroy is true, deleters otherwise
+        root_vector*        m_free_batch;
+        bool                m_free_destroy;
+
+        // destroyed objects grouped by deleters; m_free_groups has one 
+        // element for each worker of m_free_pool and is used only by free
+        // threads; m_free_groups_inline is used by the collecting thread
+        std::vector<deleter_groups> m_free_groups;
+        deleter_groups      m_free_groups_inline;
+
 		bool				collecting;
-		double				allocated_memory;
+        std::atomic<size_t> m_allocated_memory;
+        std::atomic<size_t> m_memory_limit;
+        size_t              m_root_memory;
+        size_t              m_memory_threshold;
+        size_t              m_prefetch_distance;
+
+        // if true, then state of roots is copied to m_root_state before 
+        // buffers are filtered
+        bool                m_root_snapshot;
+        std::vector<unsigned char>  m_root_state;
+
+        collector_stats     m_stats;
+
+        size_t              m_threshold;
+        size_t              m_min_threshold;
+        size_t              m_max_threshold;
+
+        // background collector thread; m_thread_mutex protects m_thread
+        // and m_stop_thread
+        std::thread*        m_thread;
+        std::mutex          m_thread_mutex;
+        std::condition_variable m_thread_cond;
+        bool                m_stop_thread;
+        std::atomic<bool>   m_background;
+        std::atomic<bool>   m_requested;
+
+        // concurrent collection
+        std::atomic<bool>   m_concurrent;
+        crc_table           m_crc_table;
+        root_vector         m_candidates;
+        std::condition_variable_any m_collect_cond;
+
+        // zero count table (single-threaded mode); objects whose reference
+        // count dropped to zero while local_ptr handles existed; the table 
+        // owns one reference to each object; m_local_objects are sorted 
+        // objects referenced by handles, valid while m_reconciling is true
+        root_vector         m_deferred;
+        root_vector         m_local_objects;
+        size_t              m_deferred_limit;
+        bool                m_reconciling;
+
+        // log of updates of field_ptr (single-threaded mode); while the log
+        // is not empty, reference counts are not exact and objects, whose
+        // count drops to zero, are stored in the zero count table
+        update_vector       m_updates;
+        update_vector       m_updates_work;
+
+		void				mark(root_buffer& roots);
+		void				scan(root_buffer& roots);
+        void                process_work();
+        void                release_impl(slot_base* s);
+
+        bool                use_parallel() const;
+		void				mark_parallel(root_buffer& roots);
+		void				scan_parallel(root_buffer& roots);
+		void				collect_roots_parallel(root_buffer& roots);
+        void                set_threads_impl(size_t n_threads);
+        void                visit_parallel_impl(slot_base* s, int type);
 
-		void				mark();
-		void				scan();
-		void				collect_roots();
+        static void         process_parallel(void* context, const work_item& item);
+        void                process_release(size_t budget);
+		void				collect_roots(root_buffer& roots);
         bool                process_buffers();
+        void                filter_buffers();
+        void                filter_snapshot(root_buffer& roots, details::age_type age, 
+                                bool young);
+        void                prefetch_root(const root_buffer& roots, size_t pos) const;
         void                process_free_objects();
+        void                free_objects(root_vector& objects, deleter_groups& buffer);
+        void                free_objects_parallel(root_vector& objects);
+        void                queue_free(root_vector& objects);
+        void                free_thread();
+        void                set_free_threads_impl(size_t n_threads);
+        void                wait_free_impl();
+
+        static void         process_free(void* context, const free_item& item);
+        static void         add_deleted(deleter_groups& groups, slot_base* s);
+        static void         release_deleted(deleter_groups& groups);
 		
 		void				add_young_impl(slot_base* s);
+        void                flush_roots_impl();
 		
 		void				collect_impl(bool collect_all);	
+        bool                collect_step_impl(size_t max_roots, time_point deadline);
 		void				start_collector_if_required();        
+        bool                is_memory_exceeded() const;
+        void                reset_memory();
+        void                adapt_threshold(size_t n_roots, size_t n_freed);
+        void                set_threshold_impl(size_t min_threshold, size_t max_threshold);
+        void                request_collection();
+        void                background_thread();
+        void                start_background_impl();
+        void                stop_background_impl();
+
+        void                collect_concurrent_impl(bool collect_all);
+        void                mark_concurrent();
+        void                trial_deletion();
+        void                validate_candidates();
+        void                collect_candidates();
+
+        crc_info&           get_crc(slot_base* s);
+        crc_info*           find_crc(slot_base* s);
+        void                crc_mark_gray(slot_base* s);
+        void                crc_decrease_child(slot_base* s);
+        void                crc_scan(slot_base* s);
+        void                crc_scan_black(slot_base* s);
+        void                crc_scan_black_child(slot_base* s);
+        void                crc_collect_white(slot_base* s);
+        void                crc_count_child(slot_base* s);
+        void                crc_remove(slot_base* s);
+        void                crc_remove_child(slot_base* s);
+        void                crc_release_child(slot_base* s);
 
-		collector();
+        bool                defer_release_impl(slot_base* s);
+        void                release_deferred_impl();
+        void                reconcile_deferred();
+        void                drop_deferred(slot_base* s);
+        void                pin_locals();
+        void                unpin_locals();
+        size_t              log_update_impl(logged_field<multithreaded>* field);
+        void                cancel_update_impl(size_t pos);
+        void                apply_updates();
+
+		collector(size_t domain);
 		~collector();
 
         friend struct collector_initializer;
+        friend size_t create_domain();
+        friend void   destroy_domain(size_t domain);
 
 	public:
+        // functions taking an object use the collector of the domain of this
+        // object; other functions take the index of the domain; the global 
+        // lock of the domain must be held unless stated otherwise
 		static void			add_young(slot_base* s);		
+        static void         flush_roots(size_t domain);
         static void         free_object(slot_base* s);
+        static void         push_work(slot_base* s, int type);
+        static void         release(slot_base* s);
         static bool         is_freeing();
-        static void			make_collect(bool all);
+        static void			make_collect(size_t domain, bool all);
+        static bool         make_collect_step(size_t domain, size_t max_roots, 
+                                time_point deadline);
+        static void         start_background_collector(size_t domain);
+        static void         stop_background_collector(size_t domain);
+        static void         set_concurrent(size_t domain, bool concurrent);
+        static bool         is_concurrent(size_t domain);
+        static void         set_threshold(size_t domain, size_t min_threshold, 
+                                size_t max_threshold);
+        static size_t       get_threshold(size_t domain);
+        static void         set_memory_threshold(size_t domain, size_t bytes);
+        static void         set_prefetch_distance(size_t domain, size_t distance);
+        static void         set_root_snapshot(size_t domain, bool snapshot);
+        static collector_stats  get_stats(size_t domain);
+
+        // lock is not required; return true if the memory limit is reached
+        // by this allocation and collection must be started by the caller
+        static bool         add_allocated(slot_base* s, size_t bytes);
+        static void         remove_allocated(slot_base* s, size_t bytes);
+
+        // return the global lock of given domain
+        static mutex_type&  get_mutex(size_t domain);
+
+        // return domain of objects created by the current thread
+        static size_t       get_current_domain();
+
+        // perform collection without stopping mutators during trial 
+        // deletion; global lock cannot be held
+        static void         make_collect_concurrent(size_t domain, bool all);
+
+        // function called by visit_children during concurrent collection
+        static void         visit_concurrent(slot_base* s, int type);
+
+        // function called by visit_children during parallel trial deletion
+        static void         visit_parallel(slot_base* s, int type);
+
+        // use n_threads threads in trial deletion; available only in
+        // lock-free mode
+        static void         set_collector_threads(size_t domain, size_t n_threads);
+
+        // free unreachable objects in n_threads threads other than the 
+        // thread performing collection; if n_threads = 0, then objects are 
+        // freed by the collecting thread; global lock cannot be held
+        static void         set_free_threads(size_t domain, size_t n_threads);
+
+        // wait until all objects queued for free threads are freed; global
+        // lock cannot be held
+        static void         wait_free(size_t domain);
+
+        // store s in the zero count table instead of releasing it, if s can
+        // be referenced by a local_ptr handle; return false if s must be 
+        // released
+        static bool         defer_release(slot_base* s);
+
+        // release objects in the zero count table, that are not referenced 
+        // by local_ptr handles
+        static void         release_deferred();
+
+        // record the first modification of field since the last 
+        // reconciliation; the current value of field is counted; return 
+        // value must be stored in field->m_log
+        static size_t       log_update(logged_field<multithreaded>* field);
+
+        // field with given m_log is destroyed
+        static void         cancel_update(size_t pos);
 
     private:
-        static collector*   get();
+        static collector*   get(size_t domain);
+        static collector*   get(slot_base* s);
 };
 
 struct CYCLIC_RC_EXPORT collector_initializer
@@ -31,7 +31,7 @@ template<class config>
 inline 
 void collector<config>::add_young(slot_base* s)
 {
-	get()->add_young_impl(s);
+	get(s)->add_young_impl(s);
 };
 
 template<class config>
@@ -39,6 +39,29 @@ inline
 void collector<config>::add_young_impl(slot_base* s)
 {
     m_objects_young->push_back(s);
+    m_root_memory   += s->get_memory_size();
+
+	start_collector_if_required();
+};
+
+template<class config>
+inline 
+void collector<config>::flush_roots(size_t domain)
+{
+	get(domain)->flush_roots_impl();
+};
+
+template<class config>
+inline 
+void collector<config>::flush_roots_impl()
+{
+    // move possible roots buffered by current thread to the young buffer
+    size_t first    = m_objects_young->size();
+    mutator_lock::flush_roots(m_domain, *m_objects_young);
+
+    for (size_t i = first; i < m_objects_young->size(); ++i)
+        m_root_memory   += (*m_objects_young)[i]->get_memory_size();
+
 	start_collector_if_required();
 };
 
@@ -46,8 +69,42 @@ template<class config>
 inline 
 void collector<config>::start_collector_if_required()
 {
-	if (!collecting && m_objects_young->size() >= threshold)
-		collect_impl(false);
+    // collection cannot be started while object is being released or while
+    // the zero count table is reconciled; it could free this object
+	if (!collecting && !m_releasing && !m_reconciling 
+                    && (m_objects_young->size() >= m_threshold
+                        || is_memory_exceeded() == true))
+    {
+        if (m_background.load(std::memory_order_relaxed) == true)
+            request_collection();
+        else
+		    collect_impl(false);
+    };
+};
+
+template<class config>
+inline 
+bool collector<config>::is_memory_exceeded() const
+{
+    if (m_memory_threshold == 0)
+        return false;
+
+    size_t bytes    = m_allocated_memory.load(std::memory_order_relaxed) 
+                    + m_root_memory;
+
+    return bytes >= m_memory_limit.load(std::memory_order_relaxed);
+};
+
+template<class config>
+inline 
+void collector<config>::reset_memory()
+{
+    size_t limit    = (m_memory_threshold == 0) ? size_t(-1)
+                    : m_allocated_memory.load(std::memory_order_relaxed) 
+                        + m_memory_threshold;
+
+    m_memory_limit.store(limit, std::memory_order_relaxed);
+    m_root_memory   = 0;
 };
 
 template<class config>
@@ -60,34 +117,251 @@ bool collector<config>::is_freeing()
 
 template<class config>
 inline
-void collector<config>::make_collect(bool all)
+void collector<config>::make_collect(size_t domain, bool all)
+{
+	collector<config>::get(domain)->collect_impl(all);
+};
+
+template<class config>
+inline
+bool collector<config>::make_collect_step(size_t domain, size_t max_roots, 
+                                          time_point deadline)
+{
+	return collector<config>::get(domain)->collect_step_impl(max_roots, deadline);
+};
+
+template<class config>
+inline
+void collector<config>::start_background_collector(size_t domain)
+{
+	collector<config>::get(domain)->start_background_impl();
+};
+
+template<class config>
+inline
+void collector<config>::stop_background_collector(size_t domain)
 {
-	collector<config>::get()->collect_impl(all);
+	collector<config>::get(domain)->stop_background_impl();
+};
+
+template<class config>
+inline
+void collector<config>::set_concurrent(size_t domain, bool concurrent)
+{
+	collector<config>::get(domain)->m_concurrent.store(concurrent);
+};
+
+template<class config>
+inline
+bool collector<config>::is_concurrent(size_t domain)
+{
+	return collector<config>::get(domain)->m_concurrent.load(std::memory_order_relaxed);
+};
+
+template<class config>
+inline
+void collector<config>::set_threshold(size_t domain, size_t min_threshold, 
+                                      size_t max_threshold)
+{
+	collector<config>::get(domain)->set_threshold_impl(min_threshold, max_threshold);
+};
+
+template<class config>
+inline
+size_t collector<config>::get_threshold(size_t domain)
+{
+	return collector<config>::get(domain)->m_threshold;
+};
+
+template<class config>
+inline
+void collector<config>::set_memory_threshold(size_t domain, size_t bytes)
+{
+	collector* c            = collector<config>::get(domain);
+    c->m_memory_threshold   = bytes;
+
+    c->reset_memory();
+};
+
+template<class config>
+inline
+void collector<config>::set_prefetch_distance(size_t domain, size_t distance)
+{
+	collector<config>::get(domain)->m_prefetch_distance = distance;
+};
+
+template<class config>
+inline
+void collector<config>::set_root_snapshot(size_t domain, bool snapshot)
+{
+	collector<config>::get(domain)->m_root_snapshot = snapshot;
+};
+
+template<class config>
+inline
+collector_stats collector<config>::get_stats(size_t domain)
+{
+	return collector<config>::get(domain)->m_stats;
+};
+
+template<class config>
+inline
+typename collector<config>::mutex_type& 
+collector<config>::get_mutex(size_t domain)
+{
+	return collector<config>::get(domain)->m_mutex;
+};
+
+template<class config>
+inline
+size_t collector<config>::get_current_domain()
+{
+    if (multithreaded == false)
+        return 0;
+
+	return current_domain::value;
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void collector<config>::prefetch_root(const root_buffer& roots, size_t pos) const
+{
+    size_t ahead    = pos + m_prefetch_distance;
+
+    if (m_prefetch_distance != 0 && ahead < roots.size())
+        CYCLIC_RC_PREFETCH(roots[ahead]);
+};
+
+template<class config>
+inline
+bool collector<config>::add_allocated(slot_base* s, size_t bytes)
+{
+    collector* c    = collector<config>::get(s);
+    size_t old      = c->m_allocated_memory.fetch_add(bytes, std::memory_order_relaxed);
+    size_t limit    = c->m_memory_limit.load(std::memory_order_relaxed);
+
+    // collection is started only by the allocation crossing the limit
+    if (old >= limit || old + bytes < limit)
+        return false;
+
+    if (c->m_background.load(std::memory_order_relaxed) == true)
+    {
+        c->request_collection();
+        return false;
+    };
+
+    return true;
+};
+
+template<class config>
+inline
+void collector<config>::remove_allocated(slot_base* s, size_t bytes)
+{
+	collector<config>::get(s)->m_allocated_memory.fetch_sub(bytes, std::memory_order_relaxed);
+};
+
+template<class config>
+inline
+void collector<config>::make_collect_concurrent(size_t domain, bool all)
+{
+	collector<config>::get(domain)->collect_concurrent_impl(all);
 };
 
 template<class config>
 inline
 void collector<config>::free_object(slot_base* s)
 {
-    collector<config>::get()->m_objects_to_free.push_back(s);
+    collector<config>::get(s)->m_objects_to_free.push_back(s);
+};
+
+template<class config>
+inline
+void collector<config>::push_work(slot_base* s, int type)
+{
+    collector<config>::get(s)->m_work.push_back(work_item{s, type});
+};
+
+template<class config>
+inline
+void collector<config>::release(slot_base* s)
+{
+    collector<config>::get(s)->release_impl(s);
+};
+
+template<class config>
+inline
+bool collector<config>::defer_release(slot_base* s)
+{
+    return collector<config>::get(s)->defer_release_impl(s);
+};
+
+// local_ptr handles and field_ptr logs are used only in single-threaded 
+// mode, where only domain 0 exists
+template<class config>
+inline
+void collector<config>::release_deferred()
+{
+    collector<config>::get(size_t(0))->release_deferred_impl();
+};
+
+template<class config>
+inline
+size_t collector<config>::log_update(logged_field<multithreaded>* field)
+{
+    return collector<config>::get(size_t(0))->log_update_impl(field);
+};
+
+template<class config>
+inline
+void collector<config>::cancel_update(size_t pos)
+{
+    collector<config>::get(size_t(0))->cancel_update_impl(pos);
+};
+
+template<class config>
+inline
+void collector<config>::set_collector_threads(size_t domain, size_t n_threads)
+{
+    collector<config>::get(domain)->set_threads_impl(n_threads);
+};
+
+template<class config>
+inline
+void collector<config>::set_free_threads(size_t domain, size_t n_threads)
+{
+    collector<config>::get(domain)->set_free_threads_impl(n_threads);
+};
+
+template<class config>
+inline
+void collector<config>::wait_free(size_t domain)
+{
+    collector<config>::get(domain)->wait_free_impl();
+};
+
+template<class config>
+inline
+collector<config>* collector<config>::get(slot_base* s)
+{
+    return get(s->get_counter().get_domain());
 };
 
 using collector_in = collector<config_nothread>;
 using collector_it = collector<config_thread>;
 
 extern collector_in * g_collector_in;
-extern collector_it * g_collector_it;
+extern collector_it * g_collector_it[max_domains];
 
 inline collector<config_nothread>* 
-collector<config_nothread>::get()
+collector<config_nothread>::get(size_t)
 {
     return g_collector_in;
 };
 
 inline collector<config_thread>* 
-collector<config_thread>::get()
+collector<config_thread>::get(size_t domain)
 {
-    return g_collector_it;
+    return g_collector_it[domain];
 };
 
 }}
\ No newline at end of file
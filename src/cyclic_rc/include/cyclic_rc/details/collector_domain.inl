@@ -0,0 +1,151 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+
+#pragma once
+
+#include "cyclic_rc/collector_domain.h"
+
+namespace cyclic_rc
+{
+
+//-----------------------------------------------------------------------
+//                      collector_domain::scope
+//-----------------------------------------------------------------------
+inline
+collector_domain::scope::scope(const collector_domain& domain)
+    :m_saved(details::current_domain::value)
+{
+    details::current_domain::value = domain.m_index;
+};
+
+inline
+collector_domain::scope::~scope()
+{
+    details::current_domain::value = m_saved;
+};
+
+//-----------------------------------------------------------------------
+//                      collector_domain
+//-----------------------------------------------------------------------
+inline
+collector_domain::collector_domain()
+    :m_index(details::create_domain())
+{};
+
+inline
+collector_domain::~collector_domain()
+{
+    details::destroy_domain(m_index);
+};
+
+inline
+size_t collector_domain::id() const
+{
+    return m_index;
+};
+
+inline
+void collector_domain::collect(bool all)
+{
+    obj_count::collect(all, m_index);
+};
+
+inline
+bool collector_domain::collect_step(size_t max_roots)
+{
+    return obj_count::collect_step(max_roots, m_index);
+};
+
+inline
+bool collector_domain::collect_step(std::chrono::microseconds max_time)
+{
+    return obj_count::collect_step(max_time, m_index);
+};
+
+inline
+void collector_domain::start_background_collector()
+{
+    obj_count::start_background_collector(m_index);
+};
+
+inline
+void collector_domain::stop_background_collector()
+{
+    obj_count::stop_background_collector(m_index);
+};
+
+inline
+void collector_domain::set_concurrent_collector(bool concurrent)
+{
+    obj_count::set_concurrent_collector(concurrent, m_index);
+};
+
+inline
+void collector_domain::set_collection_threshold(size_t min_threshold, 
+                                                size_t max_threshold)
+{
+    obj_count::set_collection_threshold(min_threshold, max_threshold, m_index);
+};
+
+inline
+size_t collector_domain::get_collection_threshold() const
+{
+    return obj_count::get_collection_threshold(m_index);
+};
+
+inline
+void collector_domain::set_memory_threshold(size_t bytes)
+{
+    obj_count::set_memory_threshold(bytes, m_index);
+};
+
+inline
+void collector_domain::set_prefetch_distance(size_t distance)
+{
+    obj_count::set_prefetch_distance(distance, m_index);
+};
+
+inline
+void collector_domain::set_root_snapshot(bool snapshot)
+{
+    obj_count::set_root_snapshot(snapshot, m_index);
+};
+
+inline
+collector_stats collector_domain::get_stats() const
+{
+    return obj_count::get_collector_stats(m_index);
+};
+
+inline
+void collector_domain::set_collector_threads(size_t n_threads)
+{
+    obj_count::set_collector_threads(n_threads, m_index);
+};
+
+inline
+void collector_domain::set_free_threads(size_t n_threads)
+{
+    obj_count::set_free_threads(n_threads, m_index);
+};
+
+};
@@ -0,0 +1,331 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/field_ptr.h"
+
+namespace cyclic_rc
+{
+
+//------------------------------------------------------------
+//                      field_ptr
+//------------------------------------------------------------
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void field_ptr<T, multithread>::init()
+{
+    slot_base* p    = m_field.m_object;
+
+    m_field.m_log   = 0;
+
+    if (!p)
+        return;
+
+    if (T::is_acyclic_type == true)
+        p->get_counter().increase_refcount_acyclic();
+    else
+		p->get_counter().increase_refcount();
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void field_ptr<T, multithread>::store(slot_base* p)
+{
+    using collector = details::collector<typename details::make_config<multithread>::type>;
+
+    // destructor of a garbage object called by the collector; references
+    // stored in garbage are not counted, therefore the old value must not
+    // be released by the reconciliation
+    if (collector::is_freeing() == true)
+    {
+        m_field.m_object    = p;
+        return;
+    };
+
+    // the old value is counted until the log is reconciled
+    if (m_field.m_log == 0)
+        m_field.m_log   = collector::log_update(&m_field);
+
+    m_field.m_object    = p;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>::field_ptr()
+{
+    m_field.m_object    = nullptr;
+    m_field.m_log       = 0;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>::field_ptr(nullptr_t)
+{
+    m_field.m_object    = nullptr;
+    m_field.m_log       = 0;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>::field_ptr(const shared_ptr<T, multithread>& p)
+{
+    m_field.m_object    = p.get();
+    init();
+};
+
+template<typename T, bool multithread>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>::field_ptr(const shared_ptr<Y, multithread>& p)
+{
+    m_field.m_object    = static_cast<T*>(p.get());
+    init();
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>::field_ptr(const field_ptr& other)
+{
+    m_field.m_object    = other.m_field.m_object;
+    init();
+};
+
+template<typename T, bool multithread>
+inline
+field_ptr<T, multithread>::~field_ptr()
+{
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+    using collector = details::collector<config>;
+
+    if (m_field.m_log != 0)
+    {
+        collector::cancel_update(m_field.m_log);
+        return;
+    };
+
+    slot_base* p    = m_field.m_object;
+
+    if (!p)
+        return;
+
+    if (T::is_acyclic_type == true)
+        obj_count::decrease_refcount_acyclic(p);
+    else
+        p->get_counter().decrease_refcount(p);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>& 
+field_ptr<T, multithread>::operator=(const field_ptr& other)
+{
+    store(other.m_field.m_object);
+    return *this;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>& 
+field_ptr<T, multithread>::operator=(const shared_ptr<T, multithread>& p)
+{
+    store(p.get());
+    return *this;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void field_ptr<T, multithread>::reset()
+{
+    store(nullptr);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename field_ptr<T, multithread>::pointer_type
+field_ptr<T, multithread>::get() const
+{
+    return static_cast<pointer_type>(m_field.m_object);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename field_ptr<T, multithread>::pointer_type
+field_ptr<T, multithread>::operator->() const
+{
+    return get();
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename field_ptr<T, multithread>::reference_type
+field_ptr<T, multithread>::operator*() const
+{
+	assert((get() != NULL) && "dereffering null pointer");
+
+    return *get();
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, multithread>::operator bool() const
+{
+    return m_field.m_object ? true : false;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+bool field_ptr<T, multithread>::operator!() const
+{
+    return !m_field.m_object;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void field_ptr<T, multithread>::visit_children(int type)
+{
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+
+    // the log is reconciled before objects are traversed, therefore the
+    // current value is counted
+    slot_base* ptr  = m_field.m_object;
+
+	if(!ptr)
+		return;
+
+    if (T::is_acyclic_type == true || ptr->get_counter().is_acyclic() == true)
+        return obj_count::visit_acyclic(ptr, type);
+
+    ptr->get_counter().do_visit_children(ptr, type);
+};
+
+//------------------------------------------------------------
+//                      field_ptr<T, true>
+//------------------------------------------------------------
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>::field_ptr()
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>::field_ptr(nullptr_t)
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>::field_ptr(const shared_ptr<T, true>& p)
+    :m_ptr(p)
+{};
+
+template<typename T>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>::field_ptr(const shared_ptr<Y, true>& p)
+    :m_ptr(p)
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>::field_ptr(const field_ptr& other)
+    :m_ptr(other.m_ptr)
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>& field_ptr<T, true>::operator=(const field_ptr& other)
+{
+    m_ptr   = other.m_ptr;
+    return *this;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>& field_ptr<T, true>::operator=(const shared_ptr<T, true>& p)
+{
+    m_ptr   = p;
+    return *this;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+void field_ptr<T, true>::reset()
+{
+    m_ptr.reset();
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+typename field_ptr<T, true>::pointer_type field_ptr<T, true>::get() const
+{
+    return m_ptr.get();
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+typename field_ptr<T, true>::pointer_type field_ptr<T, true>::operator->() const
+{
+    return m_ptr.get();
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+typename field_ptr<T, true>::reference_type field_ptr<T, true>::operator*() const
+{
+    return *m_ptr;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+field_ptr<T, true>::operator bool() const
+{
+    return m_ptr ? true : false;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+bool field_ptr<T, true>::operator!() const
+{
+    return !m_ptr;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+void field_ptr<T, true>::visit_children(int type)
+{
+    m_ptr.visit_children(type);
+};
+
+//------------------------------------------------------------
+//                      shared_ptr
+//------------------------------------------------------------
+template<typename T, bool multithread>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+shared_ptr<T, multithread>::shared_ptr(const field_ptr<Y, multithread>& r)
+: m_ptr(r.get())
+{
+	init();
+};
+
+};
@@ -0,0 +1,273 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/local_ptr.h"
+#include "cyclic_rc/details/local_roots.inl"
+
+namespace cyclic_rc
+{
+
+//------------------------------------------------------------
+//                      local_ptr
+//------------------------------------------------------------
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::local_ptr()
+    :m_ptr(nullptr)
+{
+    m_root.object   = nullptr;
+    root_list::insert(&m_root);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::local_ptr(nullptr_t)
+    :m_ptr(nullptr)
+{
+    m_root.object   = nullptr;
+    root_list::insert(&m_root);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::local_ptr(const shared_ptr<T, multithread>& p)
+    :m_ptr(p.get())
+{
+    m_root.object   = m_ptr;
+    root_list::insert(&m_root);
+};
+
+template<typename T, bool multithread>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::local_ptr(const shared_ptr<Y, multithread>& p)
+    :m_ptr(p.get())
+{
+    m_root.object   = m_ptr;
+    root_list::insert(&m_root);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::local_ptr(const local_ptr& other)
+    :m_ptr(other.m_ptr)
+{
+    m_root.object   = m_ptr;
+    root_list::insert(&m_root);
+};
+
+template<typename T, bool multithread>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::local_ptr(const local_ptr<Y, multithread>& other)
+    :m_ptr(other.get())
+{
+    m_root.object   = m_ptr;
+    root_list::insert(&m_root);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::~local_ptr()
+{
+    root_list::remove(&m_root);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>& 
+local_ptr<T, multithread>::operator=(const local_ptr& other)
+{
+    m_ptr           = other.m_ptr;
+    m_root.object   = m_ptr;
+    return *this;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>& 
+local_ptr<T, multithread>::operator=(const shared_ptr<T, multithread>& p)
+{
+    m_ptr           = p.get();
+    m_root.object   = m_ptr;
+    return *this;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void local_ptr<T, multithread>::reset()
+{
+    m_ptr           = nullptr;
+    m_root.object   = nullptr;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename local_ptr<T, multithread>::pointer_type
+local_ptr<T, multithread>::get() const
+{
+    return m_ptr;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename local_ptr<T, multithread>::pointer_type
+local_ptr<T, multithread>::operator->() const
+{
+    return m_ptr;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename local_ptr<T, multithread>::reference_type
+local_ptr<T, multithread>::operator*() const
+{
+	assert((get() != NULL) && "dereffering null pointer");
+
+    return *m_ptr;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, multithread>::operator bool() const
+{
+    return m_ptr ? true : false;
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+bool local_ptr<T, multithread>::operator!() const
+{
+    return !m_ptr;
+};
+
+//------------------------------------------------------------
+//                      local_ptr<T, true>
+//------------------------------------------------------------
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::local_ptr()
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::local_ptr(nullptr_t)
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::local_ptr(const shared_ptr<T, true>& p)
+    :m_ptr(p)
+{};
+
+template<typename T>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::local_ptr(const shared_ptr<Y, true>& p)
+    :m_ptr(p)
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::local_ptr(const local_ptr& other)
+    :m_ptr(other.m_ptr)
+{};
+
+template<typename T>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::local_ptr(const local_ptr<Y, true>& other)
+    :m_ptr(other)
+{};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>& local_ptr<T, true>::operator=(const local_ptr& other)
+{
+    m_ptr   = other.m_ptr;
+    return *this;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>& local_ptr<T, true>::operator=(const shared_ptr<T, true>& p)
+{
+    m_ptr   = p;
+    return *this;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+void local_ptr<T, true>::reset()
+{
+    m_ptr.reset();
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+typename local_ptr<T, true>::pointer_type local_ptr<T, true>::get() const
+{
+    return m_ptr.get();
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+typename local_ptr<T, true>::pointer_type local_ptr<T, true>::operator->() const
+{
+    return m_ptr.get();
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+typename local_ptr<T, true>::reference_type local_ptr<T, true>::operator*() const
+{
+    return *m_ptr;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+local_ptr<T, true>::operator bool() const
+{
+    return m_ptr ? true : false;
+};
+
+template<typename T>
+CYCLIC_RC_FORCE_INLINE
+bool local_ptr<T, true>::operator!() const
+{
+    return !m_ptr;
+};
+
+//------------------------------------------------------------
+//                      shared_ptr
+//------------------------------------------------------------
+template<typename T, bool multithread>
+template<class Y>
+CYCLIC_RC_FORCE_INLINE
+shared_ptr<T, multithread>::shared_ptr(const local_ptr<Y, multithread>& r)
+: m_ptr(r.get())
+{
+	init();
+};
+
+};
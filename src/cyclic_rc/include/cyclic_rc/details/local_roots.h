@@ -0,0 +1,96 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/config.h"
+
+#include <cstddef>
+
+#pragma warning(push)
+#pragma warning(disable: 4251) // needs to have dll-interface to be used by clients
+
+namespace cyclic_rc
+{
+
+template<bool multithread>
+class cyclic_rc_base;
+
+};
+
+namespace cyclic_rc { namespace details
+{
+
+// element of the list of objects referenced by local_ptr handles
+template<bool multithread>
+struct local_root
+{
+    cyclic_rc_base<multithread>*    object;
+    local_root*                     prev;
+    local_root*                     next;
+};
+
+// objects referenced by local_ptr handles
+//
+// local_ptr does not change reference counters; therefore, while any handle
+// exists, an object whose reference count drops to zero is not released, 
+// but stored in the zero count table of the collector. Objects in this table
+// not referenced by handles are released when the last handle is destroyed,
+// when the table grows too large, and before a collection (Deutsch-Bobrow 
+// deferred reference counting, where this list plays the role of the scanned
+// stack). Used only in the single-threaded mode.
+template<bool multithread>
+class CYCLIC_RC_EXPORT local_roots
+{
+    public:
+        using root_type     = local_root<multithread>;
+
+    private:
+        // sentinel of the circular list of handles
+        static root_type    m_head;
+
+        // number of objects in the zero count table
+        static size_t       m_deferred;
+
+        template<class config>
+        friend class collector;
+
+    public:
+        // add a handle to the list
+        static void         insert(root_type* r);
+
+        // remove a handle from the list; objects in the zero count table
+        // are released if the last handle is removed
+        static void         remove(root_type* r);
+
+        // return true if no handle exists
+        static bool         empty();
+
+        // range of handles; iteration is stopped when end() is reached
+        static root_type*   begin();
+        static root_type*   end();
+};
+
+}}
+
+#pragma warning(pop)
+
+#include "cyclic_rc/details/local_roots.inl"
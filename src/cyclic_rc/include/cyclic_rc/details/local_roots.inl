@@ -0,0 +1,77 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/details/local_roots.h"
+#include "cyclic_rc/details/obj_count.h"
+#include "cyclic_rc/details/collector.h"
+
+namespace cyclic_rc { namespace details
+{
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void local_roots<multithread>::insert(root_type* r)
+{
+    r->prev         = &m_head;
+    r->next         = m_head.next;
+    m_head.next->prev = r;
+    m_head.next     = r;
+};
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void local_roots<multithread>::remove(root_type* r)
+{
+    using config    = typename make_config<multithread>::type;
+
+    r->prev->next   = r->next;
+    r->next->prev   = r->prev;
+
+    if (m_deferred != 0 && empty() == true)
+        collector<config>::release_deferred();
+};
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+bool local_roots<multithread>::empty()
+{
+    return m_head.next == &m_head;
+};
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename local_roots<multithread>::root_type* 
+local_roots<multithread>::begin()
+{
+    return m_head.next;
+};
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+typename local_roots<multithread>::root_type* 
+local_roots<multithread>::end()
+{
+    return &m_head;
+};
+
+}}
@@ -0,0 +1,291 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#pragma once
+
+#include "cyclic_rc/config.h"
+#include "cyclic_rc/details/root_buffer.h"
+#include "cyclic_rc/details/ref_count.h"
+
+#include "boost/smart_ptr/detail/spinlock.hpp"
+
+#include <atomic>
+#include <vector>
+
+#pragma warning(push)
+#pragma warning(disable:4251)
+#pragma warning(disable:4324) // structure was padded due to alignment specifier
+
+namespace cyclic_rc
+{
+
+template<bool multithread>
+class cyclic_rc_base;
+
+};
+
+namespace cyclic_rc { namespace details
+{
+
+class spinlock;
+
+using mutator_root_vector   = std::vector<cyclic_rc_base<true>*>;
+using mutator_root_buffer   = root_buffer<cyclic_rc_base<true>*>;
+
+//-------------------------------------------------------------------------
+//                      mutator_lock
+//-------------------------------------------------------------------------
+// state of a thread registered in mutator_lock
+struct mutator_state
+{
+    // nonzero if the thread is updating counters without global lock; 
+    // index of the collector domain + 1 otherwise
+    std::atomic<int>    m_active;
+
+    // possible roots buffered by the thread, not yet seen by the collector;
+    // one buffer for each collector domain
+    mutator_root_vector m_roots[max_domains];
+
+    mutator_state*      m_next;
+    mutator_state*      m_prev;
+};
+
+struct mutator_thread
+{
+    thread_local
+    static mutator_state*   value;
+
+    // true if the thread was unregistered during thread exit; thread-local
+    // objects destroyed later must not register the thread again
+    thread_local
+    static bool             exiting;
+};
+
+// synchronization between threads updating reference counters using atomic
+// operations (mutators) and the collector; mutators enter lock-free section
+// only if the collector is not running; the collector waits until all
+// mutators leave lock-free sections; until resume_mutators is called all
+// mutators must take the global lock; additionally each mutator has its own
+// buffer of possible roots, which are moved to the collector when the buffer
+// is full, when collection starts, or when the thread exits; sections and
+// buffers are separate for each collector domain, the collector of one 
+// domain does not stop mutators updating objects from other domains; 
+// mutators can be stopped many times, they are resumed when resume_mutators
+// is called the same number of times
+class CYCLIC_RC_EXPORT mutator_lock
+{
+    public:
+        using root_vector           = mutator_root_vector;
+        using root_buffer           = mutator_root_buffer;
+        using slot_base             = cyclic_rc_base<true>;
+
+        // number of possible roots buffered by a thread before these roots
+        // are moved to the collector
+        static const size_t         root_buffer_size    = 256;
+
+    private:
+        // number of stop_mutators calls not followed by resume_mutators
+        static std::atomic<int>     m_stopped[max_domains];
+        static spinlock*            m_mutex;
+        static mutator_state*       m_threads;
+
+        // possible roots buffered by threads that have already exited; one
+        // buffer for each domain
+        static root_vector*         m_orphan_roots;
+
+        friend struct collector_initializer;
+        friend struct mutator_state_owner;
+
+    public:
+        // enter lock-free section of given domain; return false if the 
+        // collector of this domain is running or the thread is exiting; in 
+        // this case the global lock of the domain must be taken
+        static bool         try_enter(size_t domain);
+
+        // leave lock-free section
+        static void         leave();
+
+        // prevent mutators from entering lock-free sections of given domain 
+        // and wait until all mutators leave these sections; global lock of 
+        // the domain must be held
+        static void         stop_mutators(size_t domain);
+
+        // allow mutators to enter lock-free sections of given domain
+        static void         resume_mutators(size_t domain);
+
+        // return state of the current thread; the thread is registered if
+        // required; return nullptr if the thread is already exiting
+        static mutator_state*   this_thread();
+
+        // buffer possible root in the current thread; must be called inside
+        // lock-free section of given domain; return true if the buffer is 
+        // full and roots should be moved to the collector by calling 
+        // flush_roots
+        static bool         push_root(size_t domain, slot_base* s);
+
+        // move possible roots of given domain buffered by the current thread
+        // to roots; global lock of the domain must be held
+        static void         flush_roots(size_t domain, root_buffer& roots);
+
+        // move possible roots of given domain buffered by all threads to 
+        // roots; mutators of the domain must be stopped
+        static void         flush_all_roots(size_t domain, root_buffer& roots);
+
+    private:
+        static mutator_state*   get_state();
+        static mutator_state*   register_thread();
+        static void             unregister_thread(mutator_state* state);
+
+        // execute memory barrier on all processors running threads of
+        // this process
+        static void             process_memory_barrier();
+
+        // move all elements of buffer to roots
+        static void             append_roots(root_vector& roots, root_vector& buffer);
+        static void             append_roots(root_buffer& roots, root_vector& buffer);
+};
+
+//-------------------------------------------------------------------------
+//                      striped_lock
+//-------------------------------------------------------------------------
+struct striped_thread
+{
+    // index of the stripe used by the current thread + 1, or 0 if not yet
+    // assigned
+    thread_local
+    static size_t           index;
+
+    // lock of the stripe held by the current thread inside a section
+    thread_local
+    static boost::detail::spinlock* entered;
+};
+
+// synchronization between mutators and the collector used in the 
+// CYCLIC_RC_MT_STRIPED mode; a mutator updates counters holding one of 
+// n_stripes locks of the domain (a stripe) selected by the thread, instead of
+// the global lock; possible roots are buffered in a buffer of the stripe 
+// shared by all threads using this stripe; the collector stops mutators by 
+// locking all stripes of the domain; counters are protected by separate locks
+// (see striped_rc_count), therefore threads using different stripes can 
+// update the same object; the lock of a stripe is always taken before the 
+// lock of a counter and after the global lock
+class CYCLIC_RC_EXPORT striped_lock
+{
+    public:
+        using root_vector           = mutator_root_vector;
+        using root_buffer           = mutator_root_buffer;
+        using slot_base             = cyclic_rc_base<true>;
+
+        // number of stripes of a domain; must be a power of 2
+        static const size_t         n_stripes           = CYCLIC_RC_MT_STRIPES;
+
+        // number of possible roots buffered by a stripe before these roots
+        // are moved to the collector
+        static const size_t         root_buffer_size    = 256;
+
+    private:
+        using mutex_type            = boost::detail::spinlock;
+
+        // lock padded to the size of a cache line; the buffer of roots is 
+        // allocated when the first root is buffered
+        struct alignas(64) stripe
+        {
+            mutex_type      m_mutex;
+            root_vector*    m_roots;
+        };
+
+        static_assert((n_stripes & (n_stripes - 1)) == 0, 
+                      "number of stripes must be a power of 2");
+
+    private:
+        // stripes are zero initialized, i.e. unlocked, before any object is
+        // created; memory of unused domains is never touched
+        static stripe       m_stripes[max_domains][n_stripes];
+
+        // number of stop_mutators calls not followed by resume_mutators;
+        // protected by the global lock of the domain
+        static int          m_stopped[max_domains];
+
+        static std::atomic<size_t>  m_next_index;
+
+        friend struct collector_initializer;
+
+    public:
+        // lock the stripe of the current thread in given domain; always
+        // return true; sections cannot be nested
+        static bool         try_enter(size_t domain);
+
+        // unlock the stripe locked by try_enter
+        static void         leave();
+
+        // lock all stripes of given domain; global lock of the domain must
+        // be held
+        static void         stop_mutators(size_t domain);
+
+        // unlock all stripes of given domain; global lock of the domain must
+        // be held
+        static void         resume_mutators(size_t domain);
+
+        // buffer possible root in the stripe of the current thread; must be 
+        // called inside a section of given domain; return true if the buffer
+        // is full and roots should be moved to the collector by calling 
+        // flush_roots
+        static bool         push_root(size_t domain, slot_base* s);
+
+        // move possible roots of given domain buffered by the stripe of the
+        // current thread to roots; global lock of the domain must be held
+        static void         flush_roots(size_t domain, root_buffer& roots);
+
+        // move possible roots of given domain buffered by all stripes to 
+        // roots; mutators of the domain must be stopped
+        static void         flush_all_roots(size_t domain, root_buffer& roots);
+
+    private:
+        static stripe&      get_stripe(size_t domain);
+        static void         append_roots(root_buffer& roots, stripe& s);
+
+        // free buffers of roots of all stripes
+        static void         close();
+};
+
+// lock-free sections are not available; all counter updates must be
+// protected by the global lock
+struct nomutator_lock
+{
+    static bool         try_enter(size_t)           { return false; };
+    static void         leave()                     {};
+    static void         stop_mutators(size_t)       {};
+    static void         resume_mutators(size_t)     {};
+
+    template<class T>
+    static bool         push_root(size_t, T*)       { return false; };
+
+    template<class Vector>
+    static void         flush_roots(size_t, Vector&)        {};
+
+    template<class Vector>
+    static void         flush_all_roots(size_t, Vector&)    {};
+};
+
+};};
+
+#pragma warning(pop)
+
+#include "cyclic_rc/details/mutator_lock.inl"
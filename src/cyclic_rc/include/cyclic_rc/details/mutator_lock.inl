@@ -0,0 +1,131 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#pragma once
+
+#include "cyclic_rc/details/mutator_lock.h"
+
+namespace cyclic_rc { namespace details
+{
+
+CYCLIC_RC_FORCE_INLINE
+mutator_state* mutator_lock::get_state()
+{
+    mutator_state* state = mutator_thread::value;
+
+    if (state == nullptr && mutator_thread::exiting == false)
+        state = register_thread();
+
+    return state;
+};
+
+inline mutator_state* mutator_lock::this_thread()
+{
+    return get_state();
+};
+
+CYCLIC_RC_FORCE_INLINE
+bool mutator_lock::try_enter(size_t domain)
+{
+    if (m_stopped[domain].load(std::memory_order_relaxed) != 0)
+        return false;
+
+    mutator_state* state = get_state();
+
+    if (state == nullptr)
+        return false;
+
+    // store to m_active and load of m_stopped can be reordered by the
+    // processor; the collector must issue process wide memory barrier after
+    // storing m_stopped and before reading m_active
+    state->m_active.store((int)domain + 1, std::memory_order_relaxed);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    if (m_stopped[domain].load(std::memory_order_acquire) == 0)
+        return true;
+
+    state->m_active.store(0, std::memory_order_release);
+    return false;
+};
+
+CYCLIC_RC_FORCE_INLINE
+void mutator_lock::leave()
+{
+    mutator_thread::value->m_active.store(0, std::memory_order_release);
+};
+
+CYCLIC_RC_FORCE_INLINE
+bool mutator_lock::push_root(size_t domain, slot_base* s)
+{
+    // thread is already registered, since we are in lock-free section
+    root_vector& roots  = mutator_thread::value->m_roots[domain];
+    roots.push_back(s);
+
+    return roots.size() >= root_buffer_size;
+};
+
+//-------------------------------------------------------------------------
+//                      striped_lock
+//-------------------------------------------------------------------------
+CYCLIC_RC_FORCE_INLINE
+striped_lock::stripe& striped_lock::get_stripe(size_t domain)
+{
+    size_t index    = striped_thread::index;
+
+    // threads are assigned to stripes in turn
+    if (index == 0)
+    {
+        index       = m_next_index.fetch_add(1, std::memory_order_relaxed) + 1;
+        striped_thread::index   = index;
+    };
+
+    return m_stripes[domain][(index - 1) & (n_stripes - 1)];
+};
+
+CYCLIC_RC_FORCE_INLINE
+bool striped_lock::try_enter(size_t domain)
+{
+    stripe& s   = get_stripe(domain);
+    s.m_mutex.lock();
+
+    striped_thread::entered = &s.m_mutex;
+    return true;
+};
+
+CYCLIC_RC_FORCE_INLINE
+void striped_lock::leave()
+{
+    striped_thread::entered->unlock();
+};
+
+CYCLIC_RC_FORCE_INLINE
+bool striped_lock::push_root(size_t domain, slot_base* s)
+{
+    // the stripe is locked, since we are in a section
+    stripe& st  = get_stripe(domain);
+
+    if (st.m_roots == nullptr)
+        st.m_roots  = new root_vector();
+
+    st.m_roots->push_back(s);
+    return st.m_roots->size() >= root_buffer_size;
+};
+
+}}
@@ -22,8 +22,14 @@
 
 #include "cyclic_rc/config.h"
 #include "cyclic_rc/details/ref_count.h"
+#include "cyclic_rc/details/atomic_ref_count.h"
+#include "cyclic_rc/details/biased_ref_count.h"
+#include "cyclic_rc/details/striped_ref_count.h"
+#include "cyclic_rc/details/mutator_lock.h"
+#include "cyclic_rc/details/collector_stats.h"
 
 #include <vector>
+#include <chrono>
 #include "boost/smart_ptr/detail/spinlock.hpp"
 #include <atomic>
 
@@ -70,20 +76,69 @@ struct nomutex
 //-------------------------------------------------------------------------
 struct config_nothread
 {
-    using mutex_type    = nomutex;    
-    using atomic_int    = int;
+    using mutex_type        = nomutex;    
+    using atomic_int        = int;
+    using counter_type      = rc_count;
+    using mutator_lock_type = nomutator_lock;
 
     static const bool is_multithreaded  = false;
+    static const bool is_lock_free      = false;
 };
 
+#if CYCLIC_RC_MT_MODE == CYCLIC_RC_MT_LOCK_FREE
+
+struct config_thread
+{
+    using mutex_type        = spinlock;
+    using atomic_int        = std::atomic<int>;
+    using counter_type      = atomic_rc_count;
+    using mutator_lock_type = mutator_lock;
+
+    static const bool is_multithreaded  = true;
+    static const bool is_lock_free      = true;
+};
+
+#elif CYCLIC_RC_MT_MODE == CYCLIC_RC_MT_BIASED
+
+struct config_thread
+{
+    using mutex_type        = spinlock;
+    using atomic_int        = std::atomic<int>;
+    using counter_type      = biased_rc_count;
+    using mutator_lock_type = mutator_lock;
+
+    static const bool is_multithreaded  = true;
+    static const bool is_lock_free      = true;
+};
+
+#elif CYCLIC_RC_MT_MODE == CYCLIC_RC_MT_STRIPED
+
+struct config_thread
+{
+    using mutex_type        = spinlock;
+    using atomic_int        = std::atomic<int>;
+    using counter_type      = striped_rc_count;
+    using mutator_lock_type = striped_lock;
+
+    static const bool is_multithreaded  = true;
+    static const bool is_lock_free      = true;
+};
+
+#else
+
 struct config_thread
 {
-    using mutex_type    = spinlock;
-    using atomic_int    = std::atomic<int>;
+    using mutex_type        = spinlock;
+    using atomic_int        = std::atomic<int>;
+    using counter_type      = rc_count;
+    using mutator_lock_type = nomutator_lock;
 
     static const bool is_multithreaded  = true;
+    static const bool is_lock_free      = false;
 };
 
+#endif
+
 template<bool multithread>
 struct make_config{};
 
@@ -114,43 +169,83 @@ template<class config>
 class obj_count
 {
     private:
-        using counter       = details::rc_count;
+        using counter       = typename config::counter_type;
         using mutex_type    = typename config::mutex_type;
+        using mutator_lock  = typename config::mutator_lock_type;
         using atomic_int    = typename config::atomic_int;
         using slot_base     = cyclic_rc_base<config::is_multithreaded>;
 
 	private:
 		counter             m_counter;
 
-        CYCLIC_RC_EXPORT
-        static mutex_type*  m_mutex;
-
-        friend struct collector_initializer;
-
 	public:
+        // the object is assigned to the domain of the current thread
 		obj_count(bool is_acyclic);
 		~obj_count();
 
         bool                is_acyclic() const;
         size_t              get_count() const;
+        size_t              get_domain() const;
 
         void                increase_refcount();
         static void         decrease_refcount(slot_base* slot);
 
+        // report memory of object created or destroyed; collection is 
+        // started if memory threshold is exceeded
+        static void         add_allocated(slot_base* slot);
+        static void         remove_allocated(slot_base* slot);
+
         template<class T>
         static void         update(T*& old, T* n);
 
+        template<class T>
+        static void         swap(T*& a, T*& b);
+
         void                do_visit_children(slot_base* slot, int type);
 
+        // inlined version of do_visit_children; used when type is known at
+        // compile time
+        void                visit_child(slot_base* slot, int type);
+
+        // reference counting of objects, that are acyclic at compile time
+        // (see acyclic_rc_base); the collector is not involved unless an 
+        // acyclic object is referenced by garbage
+        void                increase_refcount_acyclic();
+        static void         decrease_refcount_acyclic(slot_base* slot);
+
+        // remove reference from an object visited by the collector to an
+        // acyclic object; acyclic objects are not traversed
+        static void         visit_acyclic(slot_base* slot, int type);
+
     public:
-        static void         collect(bool all);
+        // functions controlling the collector of given domain
+        static void         collect(bool all, size_t domain = 0);
+        static bool         collect_step(size_t max_roots, size_t domain = 0);
+        static bool         collect_step(std::chrono::microseconds max_time, 
+                                size_t domain = 0);
+        static void         start_background_collector(size_t domain = 0);
+        static void         stop_background_collector(size_t domain = 0);
+        static void         set_concurrent_collector(bool concurrent, 
+                                size_t domain = 0);
+        static void         set_collection_threshold(size_t min_threshold, 
+                                size_t max_threshold, size_t domain = 0);
+        static size_t       get_collection_threshold(size_t domain = 0);
+        static void         set_memory_threshold(size_t bytes, size_t domain = 0);
+        static void         set_prefetch_distance(size_t distance, size_t domain = 0);
+        static void         set_root_snapshot(bool snapshot, size_t domain = 0);
+        static collector_stats  get_collector_stats(size_t domain = 0);
+        static void         set_collector_threads(size_t n_threads, size_t domain = 0);
+        static void         set_free_threads(size_t n_threads, size_t domain = 0);
 
 	private:        
         void                increase_refcount_impl();
         static void         decrease_refcount_impl(slot_base* s);	
 
-        void                possible_root(slot_base* s);
+        // global lock of the domain of this object
+        mutex_type&         get_mutex() const;
+
         void                add_young(slot_base* s);
+        static void         flush_roots(size_t domain);
         void                free_object(slot_base* s);
         static bool         is_freeing();
         void				decrease_refcount_child(slot_base* s);
@@ -161,8 +256,12 @@ class obj_count
         void                collect_white(slot_base* s);        
         void                scan_black_child(slot_base* s);
         void                call_destructor(slot_base* s);
-        void				destroy_acyclic(slot_base* s);
         void                release(slot_base* s);
+        void                release_object(slot_base* s);
+        static void         destroy_acyclic(slot_base* s);
+
+        template<class T>
+        static void         update_acyclic(T*& old, T* n);
 
         size_t              get_cout_impl() const;
         bool                is_purple() const;
@@ -174,6 +273,7 @@ class obj_count
         bool                is_buffered() const;
 
         void                mark_nonbuffered();
+        void                mark_black();
         void                mark_age(details::age_type);
 
         friend details::collector<config>;
@@ -24,14 +24,27 @@
 #include "cyclic_rc/details/collector.h"
 
 #include <cassert>
+#include <chrono>
 #include <mutex>
+#include <utility>
 
 namespace cyclic_rc { namespace details
 {
 
 enum class collect_type : int
 {
-    decrease_ref, decrease_ref_test, scan,  collect_white, scan_black
+    decrease_ref, decrease_ref_test, scan,  collect_white, scan_black,
+
+    // concurrent collection
+    crc_decrease, crc_scan, crc_scan_black, crc_collect_white, crc_count,
+    crc_remove, crc_release,
+
+    // parallel trial deletion
+    par_decrease, par_scan, par_scan_black, par_collect_white,
+
+    // references from garbage found by parallel trial deletion to acyclic
+    // objects
+    release_acyclic
 };
 
 //-------------------------------------------------------------------------
@@ -48,28 +61,84 @@ template<class config>
 CYCLIC_RC_FORCE_INLINE
 void obj_count<config>::increase_refcount()
 {
-    std::lock_guard<mutex_type> lock(*m_mutex);
+    if (mutator_lock::try_enter(get_domain()) == true)
+    {
+        m_counter.increase_count_black();
+        mutator_lock::leave();
+        return;
+    };
+
+    std::lock_guard<mutex_type> lock(get_mutex());
 
 	increase_refcount_impl();
 };
 
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void obj_count<config>::add_allocated(slot_base* s)
+{
+    size_t bytes    = s->get_memory_size();
+
+    if (bytes == 0)
+        return;
+
+    if (details::collector<config>::add_allocated(s, bytes) == false)
+        return;
+
+    // object created by a destructor of a garbage object; the freeing 
+    // thread can hold the global lock
+    if (is_freeing() == true)
+        return;
+
+    collect(false, s->get_counter().get_domain());
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void obj_count<config>::remove_allocated(slot_base* s)
+{
+    size_t bytes    = s->get_memory_size();
+
+    if (bytes != 0)
+        details::collector<config>::remove_allocated(s, bytes);
+};
+
 template<class config>
 CYCLIC_RC_FORCE_INLINE
 void obj_count<config>::increase_refcount_impl()
 {
-	m_counter.increase_count();
-    m_counter.mark_black();
+	m_counter.increase_count_black();
 };
 
 template<class config>
 CYCLIC_RC_FORCE_INLINE
 size_t obj_count<config>::get_count() const
 {
-    std::lock_guard<mutex_type> lock(*m_mutex);
+    if (config::is_lock_free == true)
+        return m_counter.get_count();
+
+    std::lock_guard<mutex_type> lock(get_mutex());
 
     return m_counter.get_count();
 };
 
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+size_t obj_count<config>::get_domain() const
+{
+    if (config::is_multithreaded == false)
+        return 0;
+
+    return m_counter.get_domain();
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+typename obj_count<config>::mutex_type& obj_count<config>::get_mutex() const
+{
+    return details::collector<config>::get_mutex(get_domain());
+};
+
 template<class config>
 CYCLIC_RC_FORCE_INLINE
 size_t obj_count<config>::get_cout_impl() const
@@ -119,6 +188,13 @@ void obj_count<config>::mark_nonbuffered()
 	return m_counter.mark_nonbuffered();
 };
 
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void obj_count<config>::mark_black()
+{
+	return m_counter.mark_black();
+};
+
 template<class config>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::mark_age(details::age_type age)
@@ -140,13 +216,6 @@ bool obj_count<config>::is_yellow() const
 	return m_counter.is_yellow();
 };
 
-template<class config>
-CYCLIC_RC_FORCE_INLINE 
-void obj_count<config>::destroy_acyclic(slot_base* s)
-{
-	call_destructor(s);
-};
-
 template<class config>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::call_destructor(slot_base* s)
@@ -161,7 +230,7 @@ void obj_count<config>::mark_gray(slot_base* s)
 	if (m_counter.is_gray() == false)
 	{
 		m_counter.mark_gray();
-		s->visit_children((int)collect_type::decrease_ref_test);
+        details::collector<config>::push_work(s, (int)collect_type::decrease_ref_test);
 	};
 }
 
@@ -177,7 +246,7 @@ CYCLIC_RC_FORCE_INLINE
 void obj_count<config>::scan_black(slot_base* s)
 {
 	m_counter.mark_black();
-	s->visit_children((int)collect_type::scan_black);
+    details::collector<config>::push_work(s, (int)collect_type::scan_black);
 };
 
 template<class config>
@@ -203,7 +272,7 @@ void obj_count<config>::scan(slot_base* s)
 		else
 		{
 			m_counter.mark_white();
-			s->visit_children((int)collect_type::scan);
+            details::collector<config>::push_work(s, (int)collect_type::scan);
 		}				
 	};
 };
@@ -212,27 +281,12 @@ template<class config>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::decrease_refcount_child(slot_base* s)
 {
-    if (m_counter.decrease_count() == 0)
-        return release(s);
-    else if (m_counter.is_acyclic() == false)
-        return possible_root(s);
-};
-
-template<class config>
-CYCLIC_RC_FORCE_INLINE 
-void obj_count<config>::possible_root(slot_base* s)
-{
-    if (this->is_purple() == false)
-	{
-        m_counter.mark_purple();
+    bool is_root;
 
-        if (m_counter.is_young() == false)
-		{
-            m_counter.mark_buffered();
-            m_counter.mark_age(details::age_type::young);
-			add_young(s);
-		}
-	};
+    if (m_counter.decrease_count_purple(is_root) == 0)
+        return release(s);
+    else if (is_root == true)
+        return add_young(s);
 };
 
 template<class config>
@@ -241,18 +295,16 @@ void obj_count<config>::collect_white(slot_base* s)
 {
 	if (m_counter.is_white())
 	{
-        if (m_counter.is_old() == false)
-        {
-            m_counter.mark_nonbuffered();
-        };
-        if (m_counter.is_buffered() == false)
-        {
-		    m_counter.mark_black();
+        m_counter.mark_black();
 		
-            s->visit_children((int)collect_type::collect_white);
+        details::collector<config>::push_work(s, (int)collect_type::collect_white);
 
+        // object stored in a buffer is not freed here, otherwise the buffer
+        // would have to be scanned; the object is black with zero count,
+        // therefore is freed when removed from the buffer (as in 
+        // release_object)
+        if (m_counter.is_buffered() == false)
             free_object(s);
-        };
 	};
 };
 
@@ -260,13 +312,21 @@ template<class config>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::release(slot_base* s)
 {
-    if (m_counter.is_acyclic() == true)
-	{
-        this->destroy_acyclic(s);
-		return;
-	};
+    // children are released by the collector in a loop, not recursively
+    details::collector<config>::release(s);
+};
 
+template<class config>
+CYCLIC_RC_FORCE_INLINE 
+void obj_count<config>::release_object(slot_base* s)
+{
 	s->visit_children((int)collect_type::decrease_ref);
+
+    // acyclic objects are never buffered; destructor is called together 
+    // with destructors of other unreachable objects
+    if (m_counter.is_acyclic() == true)
+        return free_object(s);
+
     m_counter.mark_black();
 
     if (m_counter.is_buffered() == false)
@@ -288,7 +348,24 @@ void obj_count<config>::decrease_refcount(slot_base* s)
     if (is_freeing() == true)
         return;
 
-    std::lock_guard<mutex_type> lock(*m_mutex);
+    size_t domain   = s->get_counter().get_domain();
+
+    if (mutator_lock::try_enter(domain) == true)
+    {
+        bool is_root;
+        bool done   = s->get_counter().m_counter.try_decrease_count(is_root);
+        bool flush  = (is_root == true) && mutator_lock::push_root(domain, s);
+
+        mutator_lock::leave();
+
+        if (flush == true)
+            flush_roots(domain);
+
+        if (done == true)
+            return;
+    };
+
+    std::lock_guard<mutex_type> lock(s->get_counter().get_mutex());
 
     decrease_refcount_impl(s);
 };
@@ -297,10 +374,12 @@ template<class config>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::decrease_refcount_impl(slot_base* s)
 {    
-    if (s->get_counter().m_counter.decrease_count() == 0)
+    bool is_root;
+
+    if (s->get_counter().m_counter.decrease_count_purple(is_root) == 0)
         return s->get_counter().release(s);
-    else if (s->get_counter().m_counter.is_acyclic() == false)
-        return s->get_counter().possible_root(s);
+    else if (is_root == true)
+        return s->get_counter().add_young(s);
 };
 
 template<class config>
@@ -308,7 +387,62 @@ template<class T>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::update(T*& old, T* n)
 {
-    std::lock_guard<mutex_type> lock(*m_mutex);
+    // destructor of a garbage object called by the collector; references
+    // stored in garbage are not counted (see decrease_refcount), therefore
+    // counters are not changed; the freeing thread can hold the global
+    // lock, which must not be taken again
+    if (is_freeing() == true)
+    {
+        old         = n;
+        return;
+    };
+
+    if (T::is_acyclic_type == true)
+        return update_acyclic(old, n);
+
+    slot_base* target   = (n != nullptr) ? n : old;
+
+    if (target == nullptr)
+        return;
+
+    // objects from different domains cannot reference each other, therefore
+    // the pointer belongs to the domain of both objects
+    size_t domain       = target->get_counter().get_domain();
+
+    assert((n == nullptr || old == nullptr 
+            || old->get_counter().get_domain() == domain) 
+           && "objects from different domains");
+
+    // pointer must be changed inside lock-free section or under the global
+    // lock, otherwise the collector could see inconsistent graph
+    if (mutator_lock::try_enter(domain) == true)
+    {
+        if(n != nullptr)
+            n->get_counter().m_counter.increase_count_black();
+
+        slot_base* o    = old;
+        old             = n;
+        bool is_root    = false;
+        bool done       = (o == nullptr) 
+                        || o->get_counter().m_counter.try_decrease_count(is_root);
+        bool flush      = (is_root == true) && mutator_lock::push_root(domain, o);
+
+        mutator_lock::leave();
+
+        if (flush == true)
+            flush_roots(domain);
+
+        if (done == true)
+            return;
+
+        // reference count of o is too large until the global lock is
+        // acquired, which is safe
+        std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+        obj_count::decrease_refcount_impl(o);
+        return;
+    };
+
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
 
 	if(n != nullptr)
         n->get_counter().increase_refcount_impl();
@@ -320,10 +454,132 @@ void obj_count<config>::update(T*& old, T* n)
         obj_count::decrease_refcount_impl(o);
 };
 
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void obj_count<config>::increase_refcount_acyclic()
+{
+    // acyclic objects are not traversed by the collector, therefore only 
+    // the counter must be consistent
+    if (config::is_lock_free == true)
+        return m_counter.increase_count_acyclic();
+
+    std::lock_guard<mutex_type> lock(get_mutex());
+    m_counter.increase_count_acyclic();
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void obj_count<config>::decrease_refcount_acyclic(slot_base* s)
+{
+    // references from garbage objects are removed by the collector (see 
+    // visit_acyclic)
+    if (is_freeing() == true)
+        return;
+
+    size_t count;
+
+    if (config::is_lock_free == true)
+    {
+        count   = s->get_counter().m_counter.decrease_count_acyclic();
+    }
+    else
+    {
+        std::lock_guard<mutex_type> lock(s->get_counter().get_mutex());
+        count   = s->get_counter().m_counter.decrease_count_acyclic();
+    };
+
+    if (count != 0)
+        return;
+
+    // the object can be referenced by a local_ptr handle
+    if (config::is_multithreaded == false 
+            && details::collector<config>::defer_release(s) == true)
+    {
+        return;
+    };
+
+    destroy_acyclic(s);
+};
+
+template<class config>
+void obj_count<config>::destroy_acyclic(slot_base* s)
+{
+    // the object was never seen by the collector; it is destroyed by this
+    // thread as std::shared_ptr does; children are released by destructor
+    typename slot_base::delete_func del = s->get_deleter();
+
+    s->get_counter().call_destructor(s);
+    (*del)(s);
+};
+
+template<class config>
+template<class T>
+CYCLIC_RC_FORCE_INLINE 
+void obj_count<config>::update_acyclic(T*& old, T* n)
+{
+    // the collector does not follow pointers to acyclic objects, therefore
+    // the pointer can be changed outside of the lock-free section
+    if(n != nullptr)
+        n->get_counter().increase_refcount_acyclic();
+
+    slot_base* o    = old;
+    old             = n;
+
+    if (o != nullptr)
+        decrease_refcount_acyclic(o);
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE 
+void obj_count<config>::visit_acyclic(slot_base* s, int type)
+{
+    // slot cannot be accessed unless the reference is removed; concurrent
+    // collector can read pointers modified by mutators
+	switch((collect_type)type)
+	{
+        case collect_type::decrease_ref:
+        case collect_type::collect_white:
+        case collect_type::crc_release:
+        case collect_type::release_acyclic:
+            return s->get_counter().decrease_refcount_child(s);
+        default:
+            return;
+	};
+};
+
+template<class config>
+template<class T>
+CYCLIC_RC_FORCE_INLINE 
+void obj_count<config>::swap(T*& a, T*& b)
+{
+    if (is_freeing() == true)
+    {
+        std::swap(a, b);
+        return;
+    };
+
+    slot_base* target   = (a != nullptr) ? a : b;
+
+    if (target == nullptr)
+        return;
+
+    size_t domain       = target->get_counter().get_domain();
+
+    if (mutator_lock::try_enter(domain) == true)
+    {
+        std::swap(a, b);
+        mutator_lock::leave();
+        return;
+    };
+
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    std::swap(a, b);
+};
+
 template<class config>
 CYCLIC_RC_FORCE_INLINE 
 obj_count<config>::obj_count(bool is_acyclic)
-    :m_counter(is_acyclic)
+    :m_counter(is_acyclic, details::collector<config>::get_current_domain())
 {};
 
 template<class config>
@@ -333,10 +589,137 @@ obj_count<config>::~obj_count()
 
 template<class config>
 CYCLIC_RC_FORCE_INLINE 
-void obj_count<config>::collect(bool all)
+bool obj_count<config>::collect_step(size_t max_roots, size_t domain)
+{
+    using clock             = std::chrono::steady_clock;
+
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    return details::collector<config>::make_collect_step(domain, max_roots, 
+                                            clock::time_point::max());
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE 
+bool obj_count<config>::collect_step(std::chrono::microseconds max_time, 
+                                     size_t domain)
+{
+    using clock             = std::chrono::steady_clock;
+    clock::time_point end   = clock::now() + max_time;
+
+    // mutators are stopped once; the collector checks time between steps
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    return details::collector<config>::make_collect_step(domain, size_t(-1), end);
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE 
+void obj_count<config>::collect(bool all, size_t domain)
+{
+    using collector_type    = details::collector<config>;
+
+    // concurrent collector takes the global lock only when required
+    if (collector_type::is_concurrent(domain) == true)
+    {
+        collector_type::make_collect_concurrent(domain, all);
+    }
+    else
+    {
+        std::lock_guard<mutex_type> lock(collector_type::get_mutex(domain));
+        collector_type::make_collect(domain, all);
+    };
+
+    // destructors of all garbage objects must be called; free threads 
+    // cannot wait for themselves
+    if (all == true && is_freeing() == false)
+        collector_type::wait_free(domain);
+};
+
+template<class config>
+inline
+void obj_count<config>::start_background_collector(size_t domain)
+{
+    details::collector<config>::start_background_collector(domain);
+};
+
+template<class config>
+inline
+void obj_count<config>::stop_background_collector(size_t domain)
+{
+    // global lock cannot be held; the collector thread may wait for it
+    details::collector<config>::stop_background_collector(domain);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_concurrent_collector(bool concurrent, size_t domain)
+{
+    details::collector<config>::set_concurrent(domain, concurrent);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_collection_threshold(size_t min_threshold, 
+                                                 size_t max_threshold,
+                                                 size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    details::collector<config>::set_threshold(domain, min_threshold, max_threshold);
+};
+
+template<class config>
+inline
+size_t obj_count<config>::get_collection_threshold(size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    return details::collector<config>::get_threshold(domain);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_memory_threshold(size_t bytes, size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    details::collector<config>::set_memory_threshold(domain, bytes);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_prefetch_distance(size_t distance, size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    details::collector<config>::set_prefetch_distance(domain, distance);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_root_snapshot(bool snapshot, size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    details::collector<config>::set_root_snapshot(domain, snapshot);
+};
+
+template<class config>
+inline
+collector_stats obj_count<config>::get_collector_stats(size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    return details::collector<config>::get_stats(domain);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_collector_threads(size_t n_threads, size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    details::collector<config>::set_collector_threads(domain, n_threads);
+};
+
+template<class config>
+inline
+void obj_count<config>::set_free_threads(size_t n_threads, size_t domain)
 {
-    std::lock_guard<mutex_type> lock(*m_mutex);
-    details::collector<config>::make_collect(all);
+    // global lock cannot be held; the free thread may wait for it
+    details::collector<config>::set_free_threads(domain, n_threads);
 };
 
 template<class config>
@@ -346,6 +729,13 @@ void obj_count<config>::add_young(slot_base* s)
     details::collector<config>::add_young(s);
 };
 
+template<class config>
+void obj_count<config>::flush_roots(size_t domain)
+{
+    std::lock_guard<mutex_type> lock(details::collector<config>::get_mutex(domain));
+    details::collector<config>::flush_roots(domain);
+};
+
 template<class config>
 CYCLIC_RC_FORCE_INLINE 
 void obj_count<config>::free_object(slot_base* s)
@@ -362,6 +752,13 @@ bool obj_count<config>::is_freeing()
 
 template<class config>
 void obj_count<config>::do_visit_children(slot_base* s, int type)
+{
+    visit_child(s, type);
+};
+
+template<class config>
+CYCLIC_RC_FORCE_INLINE
+void obj_count<config>::visit_child(slot_base* s, int type)
 {
 	switch(type)
 	{
@@ -391,6 +788,25 @@ void obj_count<config>::do_visit_children(slot_base* s, int type)
 			this->collect_white(s);
 			break;
 		}
+        case collect_type::crc_decrease:
+        case collect_type::crc_scan:
+        case collect_type::crc_scan_black:
+        case collect_type::crc_collect_white:
+        case collect_type::crc_count:
+        case collect_type::crc_remove:
+        case collect_type::crc_release:
+        {
+            details::collector<config>::visit_concurrent(s, type);
+            break;
+        }
+        case collect_type::par_decrease:
+        case collect_type::par_scan:
+        case collect_type::par_scan_black:
+        case collect_type::par_collect_white:
+        {
+            details::collector<config>::visit_parallel(s, type);
+            break;
+        }
 	};
 };
 
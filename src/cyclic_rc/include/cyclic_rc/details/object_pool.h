@@ -0,0 +1,119 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/config.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#pragma warning(push)
+#pragma warning(disable: 4251) // needs to have dll-interface to be used by clients
+
+namespace cyclic_rc { namespace details
+{
+
+//-------------------------------------------------------------------------
+//                      object_pool
+//-------------------------------------------------------------------------
+// pools of memory blocks used by make_cyclic; block sizes are multiples of
+// size_step not greater than max_size, one pool for each size; memory owned
+// by pools is never returned to the system, therefore blocks can be 
+// released during destruction of global objects
+template<bool multithread>
+class CYCLIC_RC_EXPORT object_pool
+{
+    public:
+        static const size_t size_step   = 16;
+        static const size_t max_size    = 256;
+        static const size_t n_classes   = max_size / size_step;
+
+    public:
+        // index of the pool of blocks of given size; size <= max_size
+        static constexpr size_t get_size_class(size_t size)
+        {
+            return size <= size_step ? 0 : (size - 1) / size_step;
+        };
+
+        // allocate a block from the pool size_class; throw std::bad_alloc 
+        // if memory cannot be allocated
+        static void*        allocate(size_t size_class);
+
+        // return a block to the pool size_class
+        static void         deallocate(size_t size_class, void* ptr);
+
+        // return n blocks to the pool size_class; the pool is locked only
+        // once
+        static void         deallocate(size_t size_class, void** ptrs, size_t n);
+};
+
+//-------------------------------------------------------------------------
+//                      block_allocator
+//-------------------------------------------------------------------------
+// allocator of memory for objects created by make_cyclic; objects of given
+// size and alignment are allocated from object_pool if possible, otherwise
+// by std::malloc
+template<bool multithread, size_t size, size_t align>
+struct block_allocator
+{
+    using pool_type             = object_pool<multithread>;
+
+    // blocks are aligned as memory returned by operator new
+    static const bool is_pooled = size <= pool_type::max_size 
+                                && align <= alignof(std::max_align_t);
+
+    static const size_t size_class  = is_pooled ? pool_type::get_size_class(size) : 0;
+
+    static void*                allocate();
+    static void                 deallocate(void* ptr);
+    static void                 deallocate_batch(void** ptrs, size_t n);
+};
+
+//-------------------------------------------------------------------------
+//                      cyclic_object
+//-------------------------------------------------------------------------
+// object of type T created by make_cyclic; memory is released by deleters
+// of the allocator, that allocated this object
+template<class T, class allocator>
+class cyclic_object final : public T
+{
+    public:
+        using delete_func       = typename T::delete_func;
+        using batch_delete_func = typename T::batch_delete_func;
+
+    public:
+        template<class ... Args>
+        cyclic_object(Args&& ... args);
+
+        ~cyclic_object();
+
+        virtual delete_func get_deleter() const override;
+        virtual batch_delete_func get_batch_deleter() const override;
+};
+
+}}
+
+#pragma warning(pop)
+
+#include "cyclic_rc/details/object_pool.inl"
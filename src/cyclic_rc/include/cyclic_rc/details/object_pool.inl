@@ -0,0 +1,104 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/details/object_pool.h"
+
+namespace cyclic_rc { namespace details
+{
+
+//-------------------------------------------------------------------------
+//                      block_allocator
+//-------------------------------------------------------------------------
+template<bool multithread, size_t size, size_t align>
+inline
+void* block_allocator<multithread, size, align>::allocate()
+{
+    if (is_pooled == true)
+        return pool_type::allocate(size_class);
+
+    void* ptr   = std::malloc(size);
+
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+
+    return ptr;
+};
+
+template<bool multithread, size_t size, size_t align>
+inline
+void block_allocator<multithread, size, align>::deallocate(void* ptr)
+{
+    if (is_pooled == true)
+        return pool_type::deallocate(size_class, ptr);
+
+    std::free(ptr);
+};
+
+template<bool multithread, size_t size, size_t align>
+inline
+void block_allocator<multithread, size, align>::deallocate_batch(void** ptrs, size_t n)
+{
+    if (is_pooled == true)
+        return pool_type::deallocate(size_class, ptrs, n);
+
+    for (size_t i = 0; i < n; ++i)
+        std::free(ptrs[i]);
+};
+
+//-------------------------------------------------------------------------
+//                      cyclic_object
+//-------------------------------------------------------------------------
+template<class T, class allocator>
+template<class ... Args>
+inline
+cyclic_object<T, allocator>::cyclic_object(Args&& ... args)
+    : T(std::forward<Args>(args)...)
+{
+    // get_memory_size of T can be called only after T is constructed
+    T::add_allocated(this);
+};
+
+template<class T, class allocator>
+inline
+cyclic_object<T, allocator>::~cyclic_object()
+{
+    T::remove_allocated(this);
+};
+
+template<class T, class allocator>
+inline
+typename cyclic_object<T, allocator>::delete_func 
+cyclic_object<T, allocator>::get_deleter() const
+{
+    return &allocator::deallocate;
+};
+
+template<class T, class allocator>
+inline
+typename cyclic_object<T, allocator>::batch_delete_func 
+cyclic_object<T, allocator>::get_batch_deleter() const
+{
+    return &allocator::deallocate_batch;
+};
+
+}}
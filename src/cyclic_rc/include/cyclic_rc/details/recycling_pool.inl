@@ -0,0 +1,246 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/recycling_pool.h"
+
+namespace cyclic_rc
+{
+
+template<class T>
+std::atomic<size_t> recycling_pool<T>::m_max_blocks(default_max_cached / block_size);
+
+template<class T>
+recycling_pool<T>::thread_cache::thread_cache()
+    : m_remote_size(0), m_blocks(0), m_orphaned(false)
+{};
+
+template<class T>
+recycling_pool<T>::cache_holder::cache_holder()
+    : m_cache(nullptr)
+{};
+
+template<class T>
+recycling_pool<T>::cache_holder::~cache_holder()
+{
+    thread_cache* cache = m_cache;
+
+    if (cache == nullptr)
+        return;
+
+    // blocks released later, for example by the collector during 
+    // destruction of global objects, are returned as blocks of other threads
+    m_cache             = nullptr;
+
+    bool remove;
+
+    {
+        std::lock_guard<std::mutex> lock(cache->m_mutex);
+
+        cache->m_orphaned   = true;
+
+        for (block_header* header : cache->m_free)
+            release_to_system(header);
+
+        for (block_header* header : cache->m_remote)
+            release_to_system(header);
+
+        cache->m_free.clear();
+        cache->m_remote.clear();
+
+        remove  = cache->m_blocks.load() == 0;
+    };
+
+    if (remove == true)
+        delete cache;
+};
+
+template<class T>
+typename recycling_pool<T>::thread_cache* 
+recycling_pool<T>::get_cache(bool create)
+{
+    thread_local cache_holder holder;
+
+    if (holder.m_cache == nullptr && create == true)
+        holder.m_cache  = new thread_cache();
+
+    return holder.m_cache;
+};
+
+template<class T>
+inline
+typename recycling_pool<T>::block_header* 
+recycling_pool<T>::get_header(void* ptr)
+{
+    return reinterpret_cast<block_header*>(static_cast<char*>(ptr) - sizeof(block_header));
+};
+
+template<class T>
+inline
+void* recycling_pool<T>::get_block(block_header* header)
+{
+    return reinterpret_cast<char*>(header) + sizeof(block_header);
+};
+
+template<class T>
+void* recycling_pool<T>::allocate()
+{
+    static_assert(alignof(T) <= alignof(block_header), "unsupported alignment");
+
+    thread_cache* cache = get_cache(true);
+
+    // blocks released by other threads are taken when local blocks are
+    // exhausted
+    if (cache->m_free.empty() == true 
+        && cache->m_remote_size.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(cache->m_mutex);
+
+        cache->m_free.swap(cache->m_remote);
+        cache->m_remote_size.store(0, std::memory_order_relaxed);
+    };
+
+    if (cache->m_free.empty() == false)
+    {
+        block_header* header    = cache->m_free.back();
+        cache->m_free.pop_back();
+
+        return get_block(header);
+    };
+
+    block_header* header    = static_cast<block_header*>(std::malloc(block_size));
+
+    if (header == nullptr)
+        throw std::bad_alloc();
+
+    header->owner           = cache;
+    cache->m_blocks.fetch_add(1, std::memory_order_relaxed);
+
+    return get_block(header);
+};
+
+template<class T>
+void recycling_pool<T>::deallocate(void* ptr)
+{
+    block_header* header    = get_header(ptr);
+    thread_cache* owner     = header->owner;
+
+    if (owner == get_cache(false))
+        return release_local(owner, header);
+
+    bool remove;
+
+    {
+        std::lock_guard<std::mutex> lock(owner->m_mutex);
+        remove  = release_remote(header);
+    };
+
+    if (remove == true)
+        delete owner;
+};
+
+template<class T>
+void recycling_pool<T>::deallocate_batch(void** ptrs, size_t n)
+{
+    thread_cache* current   = get_cache(false);
+    size_t i                = 0;
+
+    while (i < n)
+    {
+        block_header* header    = get_header(ptrs[i]);
+        thread_cache* owner     = header->owner;
+
+        if (owner == current)
+        {
+            release_local(owner, header);
+            ++i;
+            continue;
+        };
+
+        bool remove             = false;
+
+        // garbage objects are usually allocated by few threads; the lock is
+        // taken once for consecutive blocks of the same owner
+        {
+            std::lock_guard<std::mutex> lock(owner->m_mutex);
+
+            for (; i < n; ++i)
+            {
+                header          = get_header(ptrs[i]);
+
+                if (header->owner != owner)
+                    break;
+
+                remove          = release_remote(header);
+            };
+        };
+
+        if (remove == true)
+            delete owner;
+    };
+};
+
+template<class T>
+void recycling_pool<T>::set_max_cached(size_t bytes)
+{
+    m_max_blocks.store(bytes / block_size, std::memory_order_relaxed);
+};
+
+template<class T>
+inline
+void recycling_pool<T>::release_local(thread_cache* cache, block_header* header)
+{
+    if (cache->m_free.size() < m_max_blocks.load(std::memory_order_relaxed))
+        cache->m_free.push_back(header);
+    else
+        release_to_system(header);
+};
+
+template<class T>
+inline
+bool recycling_pool<T>::release_remote(block_header* header)
+{
+    thread_cache* owner     = header->owner;
+
+    if (owner->m_orphaned == false 
+        && owner->m_remote.size() < m_max_blocks.load(std::memory_order_relaxed))
+    {
+        owner->m_remote.push_back(header);
+        owner->m_remote_size.store(owner->m_remote.size(), std::memory_order_relaxed);
+        return false;
+    };
+
+    return release_to_system(header);
+};
+
+template<class T>
+inline
+bool recycling_pool<T>::release_to_system(block_header* header)
+{
+    thread_cache* owner     = header->owner;
+    std::free(header);
+
+    size_t n                = owner->m_blocks.fetch_sub(1, std::memory_order_acq_rel);
+    return n == 1 && owner->m_orphaned == true;
+};
+
+};
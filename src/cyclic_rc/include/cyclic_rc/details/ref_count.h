@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "cyclic_rc/config.h"
+
 namespace cyclic_rc { namespace details
 {
 
@@ -30,12 +32,21 @@ enum class age_type
     old     = 2
 };
 
+// objects are assigned to collector domains (see collector_domain.h); index
+// of the domain is stored in domain_bits bits of the counter word, the 
+// reference count in remaining count_bits bits
+const size_t domain_bits    = CYCLIC_RC_DOMAIN_BITS;
+const size_t max_domains    = size_t(1) << domain_bits;
+const size_t count_bits     = sizeof(size_t) * 8 - 6 - domain_bits;
+const size_t max_count      = (size_t(1) << count_bits) - 1;
+
 class rc_count
 {
     public:
-        rc_count(bool is_acyclic);
+        rc_count(bool is_acyclic, size_t domain = 0);
 
         size_t              get_count() const;
+        size_t              get_domain() const;
 
         bool                is_count_zero() const;
         bool                is_acyclic() const;
@@ -52,6 +63,25 @@ class rc_count
         void                increase_count();
         size_t              decrease_count();
 
+        // increase count and mark this object as black; acyclic objects
+        // remain green
+        void                increase_count_black();
+
+        // increase and decrease count of an acyclic object without changing
+        // color; decrease_count_acyclic returns new count
+        void                increase_count_acyclic();
+        size_t              decrease_count_acyclic();
+
+        // decrease count if it does not drop to zero, otherwise return false;
+        // this object is marked in the same way as in decrease_count_purple
+        bool                try_decrease_count(bool& add_young);
+
+        // decrease count; if count does not drop to zero and this object is
+        // not acyclic, then mark it as purple; if additionally this object
+        // is not stored in the young buffer, then mark it as buffered young
+        // object and set add_young to true; return new count
+        size_t              decrease_count_purple(bool& add_young);
+
         void                mark_black();
         void                mark_gray();
         void                mark_white();
@@ -61,6 +91,25 @@ class rc_count
         void                mark_nonbuffered();
         void                mark_age(age_type age);
 
+        // functions used by parallel collection; in atomic_rc_count these 
+        // functions can be called concurrently by collector threads, when 
+        // mutators are stopped
+
+        // mark as gray; return false if already gray
+        bool                try_mark_gray();
+
+        // if gray, mark as black if count is nonzero, or as white otherwise;
+        // return false if not gray; is_black is set to true if marked as black
+        bool                try_scan(bool& is_black);
+
+        // increase count and mark as black; return false if already black
+        bool                increase_count_scan_black();
+
+        // change white color to black; return false if not white
+        bool                try_collect_white();
+
+        void                decrease_count_parallel();
+
     private:
         enum class color
         {
@@ -74,12 +123,16 @@ class rc_count
 
         struct  ref_info
 		{
-			size_t count        : sizeof(size_t) * 8 - 6;
+			size_t count        : count_bits;
             size_t color        : 3;            
 			size_t buffered     : 1;
             size_t age	        : 2;
 
-			ref_info(bool is_acyclic);
+        #if CYCLIC_RC_DOMAIN_BITS > 0
+            size_t domain       : domain_bits;
+        #endif
+
+			ref_info(bool is_acyclic, size_t domain);
 		};
         
         ref_info            m_ref_info;
@@ -26,13 +26,18 @@
 namespace cyclic_rc { namespace details
 {
 
-inline rc_count::ref_info::ref_info(bool is_acyclic)
+inline rc_count::ref_info::ref_info(bool is_acyclic, size_t domain)
     : count(0), buffered(0), age((int)age_type::old)
     , color(is_acyclic ? (size_t)color::green : (size_t)color::black)    
-{};
+#if CYCLIC_RC_DOMAIN_BITS > 0
+    , domain(domain)
+#endif
+{
+    (void)domain;
+};
 
-inline  rc_count::rc_count(bool is_acyclic)
-    :m_ref_info(is_acyclic)
+inline  rc_count::rc_count(bool is_acyclic, size_t domain)
+    :m_ref_info(is_acyclic, domain)
 {};
 
 inline size_t rc_count::get_count() const
@@ -40,6 +45,15 @@ inline size_t rc_count::get_count() const
     return m_ref_info.count;
 }
 
+inline size_t rc_count::get_domain() const
+{
+#if CYCLIC_RC_DOMAIN_BITS > 0
+    return m_ref_info.domain;
+#else
+    return 0;
+#endif
+}
+
 inline bool rc_count::is_count_zero() const
 {
     return get_count() == 0;
@@ -97,6 +111,7 @@ inline bool rc_count::is_old() const
 
 inline void rc_count::increase_count()
 {
+    assert(m_ref_info.count < max_count && "reference count overflow");
     ++m_ref_info.count;
 };
 
@@ -106,6 +121,55 @@ inline size_t rc_count::decrease_count()
     return --m_ref_info.count;
 };
 
+inline void rc_count::increase_count_black()
+{
+    increase_count();
+
+    if (is_acyclic() == false)
+        mark_black();
+};
+
+inline void rc_count::increase_count_acyclic()
+{
+    increase_count();
+};
+
+inline size_t rc_count::decrease_count_acyclic()
+{
+    return decrease_count();
+};
+
+inline bool rc_count::try_decrease_count(bool& add_young)
+{
+    add_young   = false;
+
+    if (m_ref_info.count <= 1)
+        return false;
+
+    decrease_count_purple(add_young);
+    return true;
+};
+
+inline size_t rc_count::decrease_count_purple(bool& add_young)
+{
+    add_young       = false;
+    size_t count    = decrease_count();
+
+    if (count == 0 || is_acyclic() == true || is_purple() == true)
+        return count;
+
+    mark_purple();
+
+    if (is_young() == false)
+    {
+        mark_buffered();
+        mark_age(details::age_type::young);
+        add_young   = true;
+    };
+
+    return count;
+};
+
 inline void rc_count::mark_black()
 {
     m_ref_info.color = (int)color::black;
@@ -146,4 +210,53 @@ inline void rc_count::mark_age(age_type age)
     m_ref_info.age = (int)age;
 };
 
+inline bool rc_count::try_mark_gray()
+{
+    if (is_gray() == true)
+        return false;
+
+    mark_gray();
+    return true;
+};
+
+inline bool rc_count::try_scan(bool& is_black)
+{
+    if (is_gray() == false)
+        return false;
+
+    is_black    = (is_count_zero() == false);
+
+    if (is_black == true)
+        mark_black();
+    else
+        mark_white();
+
+    return true;
+};
+
+inline bool rc_count::increase_count_scan_black()
+{
+    increase_count();
+
+    if (is_black() == true)
+        return false;
+
+    mark_black();
+    return true;
+};
+
+inline bool rc_count::try_collect_white()
+{
+    if (is_white() == false)
+        return false;
+
+    mark_black();
+    return true;
+};
+
+inline void rc_count::decrease_count_parallel()
+{
+    decrease_count();
+};
+
 }}
\ No newline at end of file
@@ -0,0 +1,146 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/config.h"
+
+#include <cstddef>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+
+#pragma warning(push)
+#pragma warning(disable: 4251) // needs to have dll-interface to be used by clients
+
+namespace cyclic_rc { namespace details
+{
+
+//-------------------------------------------------------------------------
+//                      root_chunk_pool
+//-------------------------------------------------------------------------
+// memory chunks of chunk_bytes bytes shared by all root buffers; at most
+// max_cached_chunks released chunks are kept for reuse, remaining chunks are
+// returned to the system
+class CYCLIC_RC_EXPORT root_chunk_pool
+{
+    public:
+        static const size_t chunk_bytes         = 8192;
+        static const size_t max_cached_chunks   = 64;
+
+    public:
+        // return a chunk; throw std::bad_alloc if memory cannot be allocated
+        static void*        allocate();
+
+        // return a chunk to the pool
+        static void         deallocate(void* chunk);
+
+        // number of chunks kept by the pool
+        static size_t       cached_chunks();
+};
+
+//-------------------------------------------------------------------------
+//                      root_buffer
+//-------------------------------------------------------------------------
+// buffer of trivially copyable elements stored in chunks drawn from 
+// root_chunk_pool; elements are never moved when the buffer grows and 
+// memory of removed elements is returned to the pool; one empty chunk is
+// kept at the end, therefore repeated push_back and pop_back at a chunk
+// boundary do not access the pool
+template<class T>
+class root_buffer
+{
+    public:
+        using value_type    = T;
+
+        // number of elements in one chunk
+        static const size_t chunk_size  = root_chunk_pool::chunk_bytes / sizeof(T);
+
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        static_assert((chunk_size & (chunk_size - 1)) == 0, "chunk_size must be a power of 2");
+
+        class const_iterator
+        {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = T;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const T*;
+                using reference         = const T&;
+
+            private:
+                const root_buffer*  m_buffer;
+                size_t              m_pos;
+
+            public:
+                const_iterator(const root_buffer* buffer, size_t pos);
+
+                const T&            operator*() const;
+                const_iterator&     operator++();
+                bool                operator==(const const_iterator& other) const;
+                bool                operator!=(const const_iterator& other) const;
+        };
+
+    private:
+        std::vector<T*>     m_chunks;
+        size_t              m_size;
+
+    public:
+        root_buffer();
+        ~root_buffer();
+
+        root_buffer(const root_buffer&) = delete;
+        root_buffer& operator=(const root_buffer&) = delete;
+
+        size_t              size() const;
+        bool                empty() const;
+
+        T&                  operator[](size_t pos);
+        const T&            operator[](size_t pos) const;
+        T&                  back();
+
+        void                push_back(const T& val);
+        void                pop_back();
+
+        // append all elements of vec
+        template<class Vector>
+        void                append(const Vector& vec);
+
+        // remove elements at positions [n, size()); n <= size()
+        void                truncate(size_t n);
+
+        // remove all elements and return all chunks to the pool
+        void                clear();
+
+        void                swap(root_buffer& other);
+
+        const_iterator      begin() const;
+        const_iterator      end() const;
+
+    private:
+        void                release_chunks(size_t n_chunks);
+};
+
+}}
+
+#pragma warning(pop)
+
+#include "cyclic_rc/details/root_buffer.inl"
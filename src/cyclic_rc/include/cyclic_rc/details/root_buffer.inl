@@ -0,0 +1,195 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/details/root_buffer.h"
+
+#include <utility>
+
+namespace cyclic_rc { namespace details
+{
+
+//------------------------------------------------------------
+//                      root_buffer
+//------------------------------------------------------------
+template<class T>
+inline
+root_buffer<T>::const_iterator::const_iterator(const root_buffer* buffer, size_t pos)
+    : m_buffer(buffer), m_pos(pos)
+{};
+
+template<class T>
+inline
+const T& root_buffer<T>::const_iterator::operator*() const
+{
+    return (*m_buffer)[m_pos];
+};
+
+template<class T>
+inline
+typename root_buffer<T>::const_iterator& root_buffer<T>::const_iterator::operator++()
+{
+    ++m_pos;
+    return *this;
+};
+
+template<class T>
+inline
+bool root_buffer<T>::const_iterator::operator==(const const_iterator& other) const
+{
+    return m_pos == other.m_pos;
+};
+
+template<class T>
+inline
+bool root_buffer<T>::const_iterator::operator!=(const const_iterator& other) const
+{
+    return m_pos != other.m_pos;
+};
+
+template<class T>
+inline
+root_buffer<T>::root_buffer()
+    : m_size(0)
+{};
+
+template<class T>
+inline
+root_buffer<T>::~root_buffer()
+{
+    clear();
+};
+
+template<class T>
+inline
+size_t root_buffer<T>::size() const
+{
+    return m_size;
+};
+
+template<class T>
+inline
+bool root_buffer<T>::empty() const
+{
+    return m_size == 0;
+};
+
+template<class T>
+CYCLIC_RC_FORCE_INLINE
+T& root_buffer<T>::operator[](size_t pos)
+{
+    return m_chunks[pos / chunk_size][pos % chunk_size];
+};
+
+template<class T>
+CYCLIC_RC_FORCE_INLINE
+const T& root_buffer<T>::operator[](size_t pos) const
+{
+    return m_chunks[pos / chunk_size][pos % chunk_size];
+};
+
+template<class T>
+inline
+T& root_buffer<T>::back()
+{
+    return (*this)[m_size - 1];
+};
+
+template<class T>
+CYCLIC_RC_FORCE_INLINE
+void root_buffer<T>::push_back(const T& val)
+{
+    if (m_size == m_chunks.size() * chunk_size)
+        m_chunks.push_back(static_cast<T*>(root_chunk_pool::allocate()));
+
+    (*this)[m_size] = val;
+    ++m_size;
+};
+
+template<class T>
+CYCLIC_RC_FORCE_INLINE
+void root_buffer<T>::pop_back()
+{
+    --m_size;
+
+    // the last chunk is released when the previous chunk is also empty
+    if (m_size + 2 * chunk_size == m_chunks.size() * chunk_size)
+        release_chunks(m_chunks.size() - 1);
+};
+
+template<class T>
+template<class Vector>
+void root_buffer<T>::append(const Vector& vec)
+{
+    for (const auto& val : vec)
+        push_back(val);
+};
+
+template<class T>
+void root_buffer<T>::truncate(size_t n)
+{
+    m_size  = n;
+
+    // one empty chunk is kept
+    release_chunks(m_size / chunk_size + 1);
+};
+
+template<class T>
+void root_buffer<T>::clear()
+{
+    m_size  = 0;
+    release_chunks(0);
+};
+
+template<class T>
+inline
+void root_buffer<T>::swap(root_buffer& other)
+{
+    m_chunks.swap(other.m_chunks);
+    std::swap(m_size, other.m_size);
+};
+
+template<class T>
+inline
+typename root_buffer<T>::const_iterator root_buffer<T>::begin() const
+{
+    return const_iterator(this, 0);
+};
+
+template<class T>
+inline
+typename root_buffer<T>::const_iterator root_buffer<T>::end() const
+{
+    return const_iterator(this, m_size);
+};
+
+template<class T>
+void root_buffer<T>::release_chunks(size_t n_chunks)
+{
+    while (m_chunks.size() > n_chunks)
+    {
+        root_chunk_pool::deallocate(m_chunks.back());
+        m_chunks.pop_back();
+    };
+};
+
+}}
@@ -22,6 +22,8 @@
 
 #include "cyclic_rc/shared_ptr.h"
 
+#include <atomic>
+
 namespace cyclic_rc
 {
 
@@ -31,11 +33,147 @@ cyclic_rc_base<multithread>::cyclic_rc_base(bool is_acyclic)
     :m_counter(is_acyclic)
 {};
 
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void cyclic_rc_base<multithread>::add_allocated(cyclic_rc_base* s)
+{
+    counter_type::add_allocated(s);
+};
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void cyclic_rc_base<multithread>::remove_allocated(cyclic_rc_base* s)
+{
+    counter_type::remove_allocated(s);
+};
+
+template<bool multithread>
+CYCLIC_RC_FORCE_INLINE
+acyclic_rc_base<multithread>::acyclic_rc_base()
+    :cyclic_rc_base<multithread>(true)
+{};
+
+namespace details
+{
+
+// relaxed load of a pointer, that can be modified by other thread; mutators
+// store pointers by single aligned writes, therefore the loaded value is 
+// either old or new value; std::atomic_ref is not available in C++14, 
+// std::atomic<T*> has the same representation as T*
+template<class T>
+CYCLIC_RC_FORCE_INLINE
+T* load_relaxed(T* const& ptr)
+{
+    static_assert(sizeof(std::atomic<T*>) == sizeof(T*), "invalid atomic pointer");
+    return reinterpret_cast<const std::atomic<T*>&>(ptr).load(std::memory_order_relaxed);
+};
+
+// visitor passed to trace functions of objects derived from traced_rc_base
+template<int type>
+struct trace_visitor
+{
+    template<class T, bool multithread>
+    CYCLIC_RC_FORCE_INLINE
+    void operator()(shared_ptr<T, multithread>& ptr) const
+    {
+        ptr.visit_child(type);
+    };
+
+    template<class T, bool multithread>
+    CYCLIC_RC_FORCE_INLINE
+    void operator()(field_ptr<T, multithread>& ptr) const
+    {
+        ptr.visit_children(type);
+    };
+};
+
+// visitor used in other phases; type is known at runtime
+struct dynamic_trace_visitor
+{
+    int m_type;
+
+    explicit dynamic_trace_visitor(int type)
+        :m_type(type)
+    {};
+
+    template<class T, bool multithread>
+    CYCLIC_RC_FORCE_INLINE
+    void operator()(shared_ptr<T, multithread>& ptr) const
+    {
+        ptr.visit_children(m_type);
+    };
+
+    template<class T, bool multithread>
+    CYCLIC_RC_FORCE_INLINE
+    void operator()(field_ptr<T, multithread>& ptr) const
+    {
+        ptr.visit_children(m_type);
+    };
+};
+
+};
+
+template<class Derived, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+traced_rc_base<Derived, multithread>::traced_rc_base(bool is_acyclic)
+    :cyclic_rc_base<multithread>(is_acyclic)
+{};
+
+template<class Derived, bool multithread>
+template<details::collect_type type>
+CYCLIC_RC_FORCE_INLINE
+void traced_rc_base<Derived, multithread>::trace_phase()
+{
+    details::trace_visitor<(int)type> visitor;
+    static_cast<Derived*>(this)->trace(visitor);
+};
+
+template<class Derived, bool multithread>
+void traced_rc_base<Derived, multithread>::visit_children(int type)
+{
+    using details::collect_type;
+
+    // phases of trial deletion are specialized; phases of the concurrent
+    // collector are handled by the generic version
+	switch((collect_type)type)
+	{
+        case collect_type::decrease_ref:
+            return trace_phase<collect_type::decrease_ref>();
+        case collect_type::decrease_ref_test:
+            return trace_phase<collect_type::decrease_ref_test>();
+        case collect_type::scan:
+            return trace_phase<collect_type::scan>();
+        case collect_type::collect_white:
+            return trace_phase<collect_type::collect_white>();
+        case collect_type::scan_black:
+            return trace_phase<collect_type::scan_black>();
+        case collect_type::par_decrease:
+            return trace_phase<collect_type::par_decrease>();
+        case collect_type::par_scan:
+            return trace_phase<collect_type::par_scan>();
+        case collect_type::par_scan_black:
+            return trace_phase<collect_type::par_scan_black>();
+        case collect_type::par_collect_white:
+            return trace_phase<collect_type::par_collect_white>();
+        default:
+        {
+            details::dynamic_trace_visitor visitor(type);
+            static_cast<Derived*>(this)->trace(visitor);
+            return;
+        }
+	};
+};
+
 template<typename T, bool multithread>
 CYCLIC_RC_FORCE_INLINE
 void shared_ptr<T, multithread>::init()
 {           
-    if (m_ptr)
+    if (!m_ptr)
+        return;
+
+    if (T::is_acyclic_type == true)
+        m_ptr->get_counter().increase_refcount_acyclic();
+    else
 		m_ptr->get_counter().increase_refcount();
 }
 
@@ -148,26 +286,30 @@ template<typename T, bool multithread>
 CYCLIC_RC_FORCE_INLINE
 void shared_ptr<T, multithread>::reset()
 {
-    this->~shared_ptr();
-    m_ptr = nullptr;
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+
+    obj_count::update(m_ptr, (pointer_type)nullptr);
 }
 
 template<typename T, bool multithread>
 CYCLIC_RC_FORCE_INLINE
 void shared_ptr<T, multithread>::reset(pointer_type p)
 {
-    if (p)
-        p->get_counter().increase_refcount();
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
 
-    this->~shared_ptr();
-    m_ptr = p;
+    obj_count::update(m_ptr, p);
 }
 
 template<typename T, bool multithread>
 CYCLIC_RC_FORCE_INLINE
 void shared_ptr<T, multithread>::swap(shared_ptr& other)
 {
-    std::swap(this->m_ptr, other.m_ptr);
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+
+    obj_count::swap(this->m_ptr, other.m_ptr);
 };
 
 template<typename T, bool multithread>
@@ -181,7 +323,15 @@ template<typename T, bool multithread>
 CYCLIC_RC_FORCE_INLINE
 void shared_ptr<T, multithread>::destroy(slot* p)
 {
-    if (p)
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+
+    if (!p)
+        return;
+
+    if (T::is_acyclic_type == true)
+        obj_count::decrease_refcount_acyclic(p);
+    else
         p->get_counter().decrease_refcount(p);
 };
 
@@ -246,10 +396,41 @@ template<typename T, bool multithread>
 CYCLIC_RC_FORCE_INLINE
 void shared_ptr<T, multithread>::visit_children(int type)
 {
-	if(!m_ptr || m_ptr->get_counter().is_acyclic() )
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+
+    // m_ptr is read once; concurrent collector can call this function
+    // while m_ptr is modified
+    slot* ptr   = details::load_relaxed(m_ptr);
+
+	if(!ptr)
 		return;
 
-    m_ptr->get_counter().do_visit_children(m_ptr, type);
+    // acyclic objects are not traversed
+    if (T::is_acyclic_type == true || ptr->get_counter().is_acyclic() == true)
+        return obj_count::visit_acyclic(ptr, type);
+
+    ptr->get_counter().do_visit_children(ptr, type);
+};
+
+template<typename T, bool multithread>
+CYCLIC_RC_FORCE_INLINE
+void shared_ptr<T, multithread>::visit_child(int type)
+{
+    using config    = typename details::make_config<multithread>::type;
+    using obj_count = details::obj_count<config>;
+
+    // same as visit_children, but the switch on type is removed by the 
+    // compiler if type is a constant
+    slot* ptr   = details::load_relaxed(m_ptr);
+
+	if(!ptr)
+		return;
+
+    if (T::is_acyclic_type == true || ptr->get_counter().is_acyclic() == true)
+        return obj_count::visit_acyclic(ptr, type);
+
+    ptr->get_counter().visit_child(ptr, type);
 };
 
 template<typename T, bool multithread>
@@ -261,4 +442,165 @@ void shared_ptr<T, multithread>::collect(bool val)
     return obj_count::collect(val);
 };
 
+template<typename T, bool multithread>
+inline
+bool shared_ptr<T, multithread>::collect_step(size_t max_roots)
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::collect_step(max_roots);
+};
+
+template<typename T, bool multithread>
+inline
+bool shared_ptr<T, multithread>::collect_step(std::chrono::microseconds max_time)
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::collect_step(max_time);
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::start_background_collector()
+{
+    static_assert(multithread == true, "background collector requires multithread = true");
+
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::start_background_collector();
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::stop_background_collector()
+{
+    static_assert(multithread == true, "background collector requires multithread = true");
+
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::stop_background_collector();
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_concurrent_collector(bool concurrent)
+{
+    static_assert(multithread == true, "concurrent collector requires multithread = true");
+
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_concurrent_collector(concurrent);
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_collection_threshold(size_t min_threshold, 
+                                                          size_t max_threshold)
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_collection_threshold(min_threshold, max_threshold);
+};
+
+template<typename T, bool multithread>
+inline
+size_t shared_ptr<T, multithread>::get_collection_threshold()
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::get_collection_threshold();
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_memory_threshold(size_t bytes)
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_memory_threshold(bytes);
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_prefetch_distance(size_t distance)
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_prefetch_distance(distance);
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_root_snapshot(bool snapshot)
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_root_snapshot(snapshot);
+};
+
+template<typename T, bool multithread>
+inline
+collector_stats shared_ptr<T, multithread>::get_collector_stats()
+{
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::get_collector_stats();
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_collector_threads(size_t n_threads)
+{
+    static_assert(multithread == true, "collector threads require multithread = true");
+
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_collector_threads(n_threads);
+};
+
+template<typename T, bool multithread>
+inline
+void shared_ptr<T, multithread>::set_free_threads(size_t n_threads)
+{
+    static_assert(multithread == true, "free threads require multithread = true");
+
+    using config            = typename details::make_config<multithread>::type;
+    using obj_count         = details::obj_count<config>;
+    return obj_count::set_free_threads(n_threads);
+};
+
+template<class T, class allocator, class ... Args>
+inline
+shared_ptr<T> allocate_cyclic(Args&& ... args)
+{
+    using object_type   = details::cyclic_object<T, allocator>;
+
+    // allocator returns memory for sizeof(T) bytes
+    static_assert(sizeof(object_type) == sizeof(T), "invalid object size");
+
+    void* ptr           = allocator::allocate();
+    object_type* obj;
+
+    try
+    {
+        obj             = ::new(ptr) object_type(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        allocator::deallocate(ptr);
+        throw;
+    };
+
+    return shared_ptr<T>(static_cast<T*>(obj));
+};
+
+template<class T, class ... Args>
+inline
+shared_ptr<T> make_cyclic(Args&& ... args)
+{
+    using allocator     = details::block_allocator<T::is_multithreaded, sizeof(T), alignof(T)>;
+    return allocate_cyclic<T, allocator>(std::forward<Args>(args)...);
+};
+
 };
@@ -0,0 +1,174 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+
+#pragma once
+
+#include "cyclic_rc/config.h"
+#include "cyclic_rc/details/ref_count.h"
+
+#include "boost/smart_ptr/detail/spinlock.hpp"
+
+#include <atomic>
+#include <mutex>
+
+#pragma warning(push)
+#pragma warning(disable:4324) // structure was padded due to alignment specifier
+
+namespace cyclic_rc { namespace details
+{
+
+// version of rc_count, that can be modified concurrently by many threads;
+// every function modifying the counter locks one of n_stripes spinlocks 
+// selected by the address of the counter (lock striping) and updates the 
+// word with plain rc_count operations; unrelated objects usually use 
+// different locks, which are stored in separate cache lines; functions have
+// the same meaning as in atomic_rc_count; at most one stripe is locked at a
+// time, and never before a stripe of striped_lock; the word is stored in
+// an atomic variable, therefore getters can read it without the lock; values,
+// that must be consistent, are read when mutators are stopped
+class CYCLIC_RC_EXPORT striped_rc_count
+{
+    public:
+        // number of locks; must be a power of 2
+        static const size_t n_stripes   = CYCLIC_RC_MT_STRIPES;
+
+    public:
+        striped_rc_count(bool is_acyclic, size_t domain = 0);
+
+        size_t              get_count() const;
+        size_t              get_domain() const;
+
+        bool                is_count_zero() const;
+        bool                is_acyclic() const;
+        bool                is_purple() const;
+        bool                is_black() const;
+        bool                is_gray() const;
+        bool                is_white() const;
+        bool                is_yellow() const;
+        bool                is_buffered() const;
+        bool                is_young() const;
+        bool                is_medium() const;
+        bool                is_old() const;
+
+        void                increase_count();
+        size_t              decrease_count();
+
+        // increase count and mark this object as black; acyclic objects
+        // remain green
+        void                increase_count_black();
+
+        // increase and decrease count of an acyclic object without changing
+        // color; decrease_count_acyclic returns new count
+        void                increase_count_acyclic();
+        size_t              decrease_count_acyclic();
+
+        // decrease count if it does not drop to zero, otherwise return false;
+        // this object is marked in the same way as in decrease_count_purple
+        bool                try_decrease_count(bool& add_young);
+
+        // decrease count; if count does not drop to zero and this object is
+        // not acyclic, then mark it as purple; if additionally this object
+        // is not stored in the young buffer, then mark it as buffered young
+        // object and set add_young to true; return new count
+        size_t              decrease_count_purple(bool& add_young);
+
+        void                mark_black();
+        void                mark_gray();
+        void                mark_white();
+        void                mark_purple();
+        void                mark_yellow();
+        void                mark_buffered();
+        void                mark_nonbuffered();
+        void                mark_age(age_type age);
+
+        // functions used by parallel collection
+
+        // mark as gray; return false if already gray
+        bool                try_mark_gray();
+
+        // if gray, mark as black if count is nonzero, or as white otherwise;
+        // return false if not gray; is_black is set to true if marked as black
+        bool                try_scan(bool& is_black);
+
+        // increase count and mark as black; return false if already black
+        bool                increase_count_scan_black();
+
+        // change white color to black; return false if not white
+        bool                try_collect_white();
+
+        void                decrease_count_parallel();
+
+    private:
+        using mutex_type    = boost::detail::spinlock;
+
+        // lock padded to the size of a cache line
+        struct alignas(64) stripe
+        {
+            mutex_type      m_mutex;
+        };
+
+        static_assert((n_stripes & (n_stripes - 1)) == 0, 
+                      "number of stripes must be a power of 2");
+
+        // copy of the counter word modified under the lock of the counter;
+        // the copy is stored, when this object is destroyed
+        class locked_count
+        {
+            public:
+                explicit locked_count(striped_rc_count& owner);
+                ~locked_count();
+
+                locked_count(const locked_count&) = delete;
+                locked_count& operator=(const locked_count&) = delete;
+
+                rc_count*       operator->();
+
+            private:
+                striped_rc_count&           m_owner;
+                std::lock_guard<mutex_type> m_lock;
+                rc_count                    m_count;
+        };
+
+        static_assert(sizeof(rc_count) == sizeof(size_t), "invalid counter size");
+
+    private:
+        // return the lock protecting this counter
+        mutex_type&         get_mutex();
+
+        // decode the counter word; the word can be changed by other threads
+        // unless the lock is held or mutators are stopped
+        rc_count            load() const;
+        void                store(const rc_count& count);
+
+    private:
+        // locks are zero initialized, i.e. unlocked, before any object is
+        // created
+        static stripe       m_stripes[n_stripes];
+
+        std::atomic<size_t> m_word;
+};
+
+};};
+
+#pragma warning(pop)
+
+#include "striped_ref_count.inl"
@@ -0,0 +1,265 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+
+#pragma once
+
+#include "striped_ref_count.h"
+
+#include <mutex>
+#include <atomic>
+#include <cstring>
+
+namespace cyclic_rc { namespace details
+{
+
+inline striped_rc_count::striped_rc_count(bool is_acyclic, size_t domain)
+{
+    store(rc_count(is_acyclic, domain));
+};
+
+inline striped_rc_count::mutex_type& striped_rc_count::get_mutex()
+{
+    // Fibonacci hashing; counters of neighbouring objects are mapped to
+    // different stripes
+    size_t hash     = size_t(this) * size_t(0x9E3779B97F4A7C15ull);
+    size_t pos      = (hash >> (sizeof(size_t) * 8 - 16)) & (n_stripes - 1);
+
+    return m_stripes[pos].m_mutex;
+};
+
+inline rc_count striped_rc_count::load() const
+{
+    size_t word     = m_word.load(std::memory_order_relaxed);
+
+    rc_count count(false);
+    std::memcpy(&count, &word, sizeof(word));
+    return count;
+};
+
+inline void striped_rc_count::store(const rc_count& count)
+{
+    size_t word;
+    std::memcpy(&word, &count, sizeof(word));
+
+    m_word.store(word, std::memory_order_relaxed);
+};
+
+inline striped_rc_count::locked_count::locked_count(striped_rc_count& owner)
+    : m_owner(owner), m_lock(owner.get_mutex()), m_count(owner.load())
+{};
+
+inline striped_rc_count::locked_count::~locked_count()
+{
+    m_owner.store(m_count);
+};
+
+inline rc_count* striped_rc_count::locked_count::operator->()
+{
+    return &m_count;
+};
+
+inline size_t striped_rc_count::get_count() const
+{
+    return load().get_count();
+};
+
+inline size_t striped_rc_count::get_domain() const
+{
+    return load().get_domain();
+};
+
+inline bool striped_rc_count::is_count_zero() const
+{
+    return load().is_count_zero();
+};
+
+inline bool striped_rc_count::is_acyclic() const
+{
+    return load().is_acyclic();
+};
+
+inline bool striped_rc_count::is_purple() const
+{
+    return load().is_purple();
+};
+
+inline bool striped_rc_count::is_black() const
+{
+    return load().is_black();
+};
+
+inline bool striped_rc_count::is_gray() const
+{
+    return load().is_gray();
+};
+
+inline bool striped_rc_count::is_white() const
+{
+    return load().is_white();
+};
+
+inline bool striped_rc_count::is_yellow() const
+{
+    return load().is_yellow();
+};
+
+inline bool striped_rc_count::is_buffered() const
+{
+    return load().is_buffered();
+};
+
+inline bool striped_rc_count::is_young() const
+{
+    return load().is_young();
+};
+
+inline bool striped_rc_count::is_medium() const
+{
+    return load().is_medium();
+};
+
+inline bool striped_rc_count::is_old() const
+{
+    return load().is_old();
+};
+
+inline void striped_rc_count::increase_count()
+{
+    locked_count count(*this);
+    count->increase_count();
+};
+
+inline size_t striped_rc_count::decrease_count()
+{
+    locked_count count(*this);
+    return count->decrease_count();
+};
+
+inline void striped_rc_count::increase_count_black()
+{
+    locked_count count(*this);
+    count->increase_count_black();
+};
+
+inline void striped_rc_count::increase_count_acyclic()
+{
+    locked_count count(*this);
+    count->increase_count_acyclic();
+};
+
+inline size_t striped_rc_count::decrease_count_acyclic()
+{
+    locked_count count(*this);
+    return count->decrease_count_acyclic();
+};
+
+inline bool striped_rc_count::try_decrease_count(bool& add_young)
+{
+    locked_count count(*this);
+    return count->try_decrease_count(add_young);
+};
+
+inline size_t striped_rc_count::decrease_count_purple(bool& add_young)
+{
+    locked_count count(*this);
+    return count->decrease_count_purple(add_young);
+};
+
+inline void striped_rc_count::mark_black()
+{
+    locked_count count(*this);
+    count->mark_black();
+};
+
+inline void striped_rc_count::mark_gray()
+{
+    locked_count count(*this);
+    count->mark_gray();
+};
+
+inline void striped_rc_count::mark_white()
+{
+    locked_count count(*this);
+    count->mark_white();
+};
+
+inline void striped_rc_count::mark_purple()
+{
+    locked_count count(*this);
+    count->mark_purple();
+};
+
+inline void striped_rc_count::mark_yellow()
+{
+    locked_count count(*this);
+    count->mark_yellow();
+};
+
+inline void striped_rc_count::mark_buffered()
+{
+    locked_count count(*this);
+    count->mark_buffered();
+};
+
+inline void striped_rc_count::mark_nonbuffered()
+{
+    locked_count count(*this);
+    count->mark_nonbuffered();
+};
+
+inline void striped_rc_count::mark_age(age_type age)
+{
+    locked_count count(*this);
+    count->mark_age(age);
+};
+
+inline bool striped_rc_count::try_mark_gray()
+{
+    locked_count count(*this);
+    return count->try_mark_gray();
+};
+
+inline bool striped_rc_count::try_scan(bool& is_black)
+{
+    locked_count count(*this);
+    return count->try_scan(is_black);
+};
+
+inline bool striped_rc_count::increase_count_scan_black()
+{
+    locked_count count(*this);
+    return count->increase_count_scan_black();
+};
+
+inline bool striped_rc_count::try_collect_white()
+{
+    locked_count count(*this);
+    return count->try_collect_white();
+};
+
+inline void striped_rc_count::decrease_count_parallel()
+{
+    locked_count count(*this);
+    count->decrease_count_parallel();
+};
+
+}}
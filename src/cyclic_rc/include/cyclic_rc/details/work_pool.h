@@ -0,0 +1,127 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace cyclic_rc { namespace details
+{
+
+//-------------------------------------------------------------------------
+//                      work_pool
+//-------------------------------------------------------------------------
+// pool of threads processing items of type Item; processing of an item can
+// create new items, which are added by calling push; each worker stores 
+// items in a private stack; part of these items is moved to the shared queue
+// of the worker if this queue is empty; workers without items steal items 
+// from shared queues of other workers; processing is finished when all 
+// workers are idle and all shared queues are empty
+template<class Item>
+class work_pool
+{
+    public:
+        using item_type     = Item;
+        using item_vector   = std::vector<Item>;
+
+        // function called on every item; context is the argument passed
+        // to run
+        using function_type = void (*)(void* context, const Item& item);
+
+    private:
+        // minimum size of the private stack, when items are moved to the
+        // shared queue
+        static const size_t share_size  = 64;
+
+        struct worker
+        {
+            item_vector         m_local;
+            std::deque<Item>    m_shared;
+            std::mutex          m_mutex;
+
+            // number of items in m_shared
+            std::atomic<size_t> m_shared_size;
+        };
+
+        using worker_vector = std::vector<worker*>;
+
+    private:
+        worker_vector           m_workers;
+        std::vector<std::thread>m_threads;
+
+        // function processing items in current run
+        function_type           m_function;
+        void*                   m_context;
+
+        // number of workers, that have no items
+        std::atomic<size_t>     m_idle;
+
+        // threads are woken up when m_run is increased
+        std::mutex              m_mutex;
+        std::condition_variable m_cond;
+        size_t                  m_run;
+        size_t                  m_finished;
+        bool                    m_stop;
+
+    public:
+        // create a pool with n_threads additional threads; the thread 
+        // calling run is also a worker
+        work_pool(size_t n_threads);
+
+        // stop all threads
+        ~work_pool();
+
+        work_pool(const work_pool&) = delete;
+        work_pool& operator=(const work_pool&) = delete;
+
+        // number of workers including the thread calling run
+        size_t                  get_num_workers() const;
+
+        // process items and all items added by push; return when all items
+        // are processed; items vector is cleared
+        void                    run(item_vector& items, function_type func, 
+                                    void* context);
+
+        // add new item processed by the current worker; can be called only
+        // by function called by run
+        static void             push(const Item& item);
+
+        // index of the current worker in [0, get_num_workers())
+        static size_t           get_worker_index();
+
+    private:
+        static worker*&         current_worker();
+        static size_t&          current_index();
+
+        void                    thread_func(size_t index);
+        void                    work(size_t index);
+        bool                    steal(size_t index, Item& item);
+        void                    share(worker* w);
+};
+
+}}
+
+#include "cyclic_rc/details/work_pool.inl"
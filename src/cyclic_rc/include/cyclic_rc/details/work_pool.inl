@@ -0,0 +1,255 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/details/work_pool.h"
+
+namespace cyclic_rc { namespace details
+{
+
+template<class Item>
+work_pool<Item>::work_pool(size_t n_threads)
+    : m_function(nullptr), m_context(nullptr), m_idle(0), m_run(0)
+    , m_finished(0), m_stop(false)
+{
+    for (size_t i = 0; i < n_threads + 1; ++i)
+        m_workers.push_back(new worker());
+
+    for (size_t i = 0; i < n_threads; ++i)
+        m_threads.push_back(std::thread(&work_pool::thread_func, this, i + 1));
+};
+
+template<class Item>
+work_pool<Item>::~work_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop  = true;
+        m_cond.notify_all();
+    };
+
+    for (std::thread& th : m_threads)
+        th.join();
+
+    for (worker* w : m_workers)
+        delete w;
+};
+
+template<class Item>
+size_t work_pool<Item>::get_num_workers() const
+{
+    return m_workers.size();
+};
+
+template<class Item>
+typename work_pool<Item>::worker*& work_pool<Item>::current_worker()
+{
+    thread_local worker* w  = nullptr;
+    return w;
+};
+
+template<class Item>
+size_t& work_pool<Item>::current_index()
+{
+    thread_local size_t index   = 0;
+    return index;
+};
+
+template<class Item>
+size_t work_pool<Item>::get_worker_index()
+{
+    return current_index();
+};
+
+template<class Item>
+void work_pool<Item>::push(const Item& item)
+{
+    current_worker()->m_local.push_back(item);
+};
+
+template<class Item>
+void work_pool<Item>::run(item_vector& items, function_type func, void* context)
+{
+    // initial items are distributed between shared queues
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        worker* w   = m_workers[i % m_workers.size()];
+        w->m_shared.push_back(items[i]);
+    };
+
+    for (worker* w : m_workers)
+        w->m_shared_size.store(w->m_shared.size(), std::memory_order_relaxed);
+
+    items.clear();
+
+    m_function  = func;
+    m_context   = context;
+    m_idle.store(0, std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished  = 0;
+        ++m_run;
+        m_cond.notify_all();
+    };
+
+    work(0);
+
+    // wait until other threads leave work function
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this]() { return m_finished == m_threads.size(); });
+};
+
+template<class Item>
+void work_pool<Item>::thread_func(size_t index)
+{
+    size_t run  = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [&]() { return m_stop == true || m_run != run; });
+
+            if (m_stop == true)
+                return;
+
+            run     = m_run;
+        };
+
+        work(index);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_finished;
+        m_cond.notify_all();
+    };
+};
+
+template<class Item>
+void work_pool<Item>::work(size_t index)
+{
+    worker* w           = m_workers[index];
+    current_worker()    = w;
+    current_index()     = index;
+
+    Item item;
+
+    for (;;)
+    {
+        while (w->m_local.empty() == false)
+        {
+            item        = w->m_local.back();
+            w->m_local.pop_back();
+
+            m_function(m_context, item);
+
+            if (w->m_local.size() >= share_size 
+                && w->m_shared_size.load(std::memory_order_relaxed) == 0)
+            {
+                share(w);
+            };
+        };
+
+        if (steal(index, item) == true)
+        {
+            w->m_local.push_back(item);
+            continue;
+        };
+
+        // no items; wait until other workers share items or all workers
+        // are idle
+        m_idle.fetch_add(1, std::memory_order_acq_rel);
+
+        for (;;)
+        {
+            bool has_items  = false;
+
+            for (worker* other : m_workers)
+            {
+                if (other->m_shared_size.load(std::memory_order_acquire) != 0)
+                {
+                    has_items   = true;
+                    break;
+                };
+            };
+
+            if (has_items == true)
+            {
+                m_idle.fetch_sub(1, std::memory_order_acq_rel);
+                break;
+            };
+
+            // idle workers have no items and cannot create new items
+            if (m_idle.load(std::memory_order_acquire) == m_workers.size())
+            {
+                current_worker()    = nullptr;
+                return;
+            }
+
+            std::this_thread::yield();
+        };
+    };
+};
+
+template<class Item>
+bool work_pool<Item>::steal(size_t index, Item& item)
+{
+    size_t n    = m_workers.size();
+
+    // own queue is checked first
+    for (size_t i = 0; i < n; ++i)
+    {
+        worker* w   = m_workers[(index + i) % n];
+
+        if (w->m_shared_size.load(std::memory_order_acquire) == 0)
+            continue;
+
+        std::lock_guard<std::mutex> lock(w->m_mutex);
+
+        if (w->m_shared.empty() == true)
+            continue;
+
+        item        = w->m_shared.front();
+        w->m_shared.pop_front();
+        w->m_shared_size.store(w->m_shared.size(), std::memory_order_release);
+
+        return true;
+    };
+
+    return false;
+};
+
+template<class Item>
+void work_pool<Item>::share(worker* w)
+{
+    // oldest items usually represent largest parts of the graph
+    size_t n    = w->m_local.size() / 2;
+
+    std::lock_guard<std::mutex> lock(w->m_mutex);
+
+    w->m_shared.insert(w->m_shared.end(), w->m_local.begin(), w->m_local.begin() + n);
+    w->m_local.erase(w->m_local.begin(), w->m_local.begin() + n);
+
+    w->m_shared_size.store(w->m_shared.size(), std::memory_order_release);
+};
+
+}}
@@ -0,0 +1,152 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/shared_ptr.h"
+#include "cyclic_rc/details/collector.h"
+
+namespace cyclic_rc
+{
+
+// pointer to a managed object intended for members of managed objects, 
+// that are modified frequently
+//
+// In single-threaded mode only the first modification of a field_ptr since
+// the last reconciliation changes reference counters: the old value is 
+// recorded in a log of updates and the field is marked as modified; next
+// assignments only store the pointer. The log is reconciled when it grows
+// large, when the zero count table of local_ptr is reconciled, and before a
+// collection: current values of modified fields are counted and logged old 
+// values are released (update coalescing of Levanoni and Petrank). While
+// the log is not empty, objects whose reference count drops to zero are 
+// released only after reconciliation.
+//
+// field_ptr must be visited by visit_children as shared_ptr. In 
+// multithreaded mode field_ptr<T, true> holds a counted reference and 
+// behaves as shared_ptr.
+template<typename T, bool multithread = is_multithreaded<T>::value>
+class field_ptr
+{
+    private:
+        // pointer type of managed object
+        using pointer_type  = T*;
+
+        // reference type of managed object
+        using reference_type = T&;
+
+        using slot_base     = cyclic_rc_base<multithread>;
+        using field_type    = details::logged_field<multithread>;
+
+    public:
+        // create empty object
+        field_ptr();
+
+        // create empty object
+        field_ptr(nullptr_t);
+
+        // initialize with object stored in p; reference counter is increased
+        field_ptr(const shared_ptr<T, multithread>& p);
+
+        // initialize with object stored in p of other type
+        template<class Y>
+        field_ptr(const shared_ptr<Y, multithread>& p);
+
+        // copy constructor; reference counter is increased
+        field_ptr(const field_ptr& other);
+
+        // destructor; reference counter is decreased if this field was not
+        // modified since the last reconciliation; otherwise the logged old
+        // value is released by the next reconciliation
+        ~field_ptr();
+
+        // assignments; reference counters are changed only by the first 
+        // modification since the last reconciliation
+        field_ptr&          operator=(const field_ptr& other);
+        field_ptr&          operator=(const shared_ptr<T, multithread>& p);
+
+        // store nullptr; equivalent to operator=(shared_ptr())
+        void                reset();
+
+        // get stored pointer
+        pointer_type        get() const;
+
+        // return stored pointer in order to access one of its members; this 
+        // object cannot be empty
+        pointer_type        operator->() const;
+
+        // return a reference to stored object; this object cannot be empty
+        reference_type      operator*() const;
+
+        // cast operator to boolean value
+        explicit            operator bool() const;
+
+        // boolean negation operator
+        bool                operator!() const;
+
+        // call collector function on stored pointer; see 
+        // shared_ptr::visit_children
+        void                visit_children(int type);
+
+    private:
+        void                init();
+        void                store(slot_base* p);
+
+    private:
+        field_type          m_field;
+};
+
+// multithreaded version of field_ptr
+template<typename T>
+class field_ptr<T, true>
+{
+    private:
+        using pointer_type  = T*;
+        using reference_type = T&;
+
+    public:
+        field_ptr();
+        field_ptr(nullptr_t);
+        field_ptr(const shared_ptr<T, true>& p);
+
+        template<class Y>
+        field_ptr(const shared_ptr<Y, true>& p);
+
+        field_ptr(const field_ptr& other);
+
+        field_ptr&          operator=(const field_ptr& other);
+        field_ptr&          operator=(const shared_ptr<T, true>& p);
+
+        void                reset();
+        pointer_type        get() const;
+        pointer_type        operator->() const;
+        reference_type      operator*() const;
+        explicit            operator bool() const;
+        bool                operator!() const;
+        void                visit_children(int type);
+
+    private:
+        shared_ptr<T, true> m_ptr;
+};
+
+};
+
+#include "cyclic_rc/details/field_ptr.inl"
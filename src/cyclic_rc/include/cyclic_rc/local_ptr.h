@@ -0,0 +1,154 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include "cyclic_rc/shared_ptr.h"
+#include "cyclic_rc/details/local_roots.h"
+
+namespace cyclic_rc
+{
+
+// handle of a managed object intended for local variables and function 
+// arguments
+//
+// Copying, assigning and destroying local_ptr does not change reference 
+// counters and does not mark objects as possible roots of cycles; only 
+// references stored in shared_ptr are counted. While any local_ptr exists,
+// objects whose reference count drops to zero are not released, but stored
+// in a zero count table; objects in this table not referenced by any 
+// local_ptr are released when the last local_ptr is destroyed, when the 
+// table grows large, and before a collection (deferred reference counting
+// of Deutsch and Bobrow, where the list of existing handles replaces 
+// scanning of the stack). Objects referenced by local_ptr are never 
+// collected.
+//
+// local_ptr is cheap to create and destroy, but every existing handle delays
+// releasing of unreferenced objects; handles should be short lived.
+//
+// In multithreaded mode other threads cannot be inspected, when an object
+// is released; local_ptr<T, true> holds a counted reference and behaves as
+// shared_ptr.
+template<typename T, bool multithread = is_multithreaded<T>::value>
+class local_ptr
+{
+    private:
+        // pointer type of managed object
+        using pointer_type  = T*;
+
+        // reference type of managed object
+        using reference_type = T&;
+
+        using root_type     = details::local_root<multithread>;
+        using root_list     = details::local_roots<multithread>;
+
+    public:
+        // create empty handle
+        local_ptr();
+
+        // create empty handle
+        local_ptr(nullptr_t);
+
+        // create handle to object stored in p; reference counter is not 
+        // changed
+        local_ptr(const shared_ptr<T, multithread>& p);
+
+        // create handle to object stored in p of other type
+        template<class Y>
+        local_ptr(const shared_ptr<Y, multithread>& p);
+
+        // copy constructor; reference counter is not changed
+        local_ptr(const local_ptr& other);
+
+        // copy constructor from local_ptr of other type
+        template<class Y>
+        local_ptr(const local_ptr<Y, multithread>& other);
+
+        // destructor; objects in the zero count table are released, if 
+        // this is the last handle
+        ~local_ptr();
+
+        // assignments; reference counters are not changed
+        local_ptr&          operator=(const local_ptr& other);
+        local_ptr&          operator=(const shared_ptr<T, multithread>& p);
+
+        // set stored pointer to nullptr
+        void                reset();
+
+        // get stored pointer
+        pointer_type        get() const;
+
+        // return stored pointer in order to access one of its members; this 
+        // handle cannot be empty
+        pointer_type        operator->() const;
+
+        // return a reference to stored object; this handle cannot be empty
+        reference_type      operator*() const;
+
+        // cast operator to boolean value
+        explicit            operator bool() const;
+
+        // boolean negation operator
+        bool                operator!() const;
+
+    private:
+        pointer_type        m_ptr;
+        root_type           m_root;
+};
+
+// multithreaded version of local_ptr
+template<typename T>
+class local_ptr<T, true>
+{
+    private:
+        using pointer_type  = T*;
+        using reference_type = T&;
+
+    public:
+        local_ptr();
+        local_ptr(nullptr_t);
+        local_ptr(const shared_ptr<T, true>& p);
+
+        template<class Y>
+        local_ptr(const shared_ptr<Y, true>& p);
+
+        local_ptr(const local_ptr& other);
+
+        template<class Y>
+        local_ptr(const local_ptr<Y, true>& other);
+
+        local_ptr&          operator=(const local_ptr& other);
+        local_ptr&          operator=(const shared_ptr<T, true>& p);
+
+        void                reset();
+        pointer_type        get() const;
+        pointer_type        operator->() const;
+        reference_type      operator*() const;
+        explicit            operator bool() const;
+        bool                operator!() const;
+
+    private:
+        shared_ptr<T, true> m_ptr;
+};
+
+};
+
+#include "cyclic_rc/details/local_ptr.inl"
@@ -0,0 +1,132 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+namespace cyclic_rc
+{
+
+// per-thread cache of memory blocks for objects of type T
+//
+// Blocks released by the thread, that allocated them, are kept in a cache 
+// of this thread and reused by next allocations. Blocks released by other 
+// threads (for example by the background collector or by free threads) are
+// returned to the cache of the owning thread and reused when the local cache
+// is empty. Blocks exceeding the limit set by set_max_cached are returned to
+// the system. When a thread exits, its cached blocks are returned to the 
+// system; blocks still in use are released directly when freed.
+//
+// recycling_pool can be used as the allocator of allocate_cyclic:
+//      allocate_cyclic<T, recycling_pool<T>>(args...)
+// or objects allocated by allocate can return deallocate and 
+// deallocate_batch from cyclic_rc_base::get_deleter and get_batch_deleter.
+template<class T>
+class recycling_pool
+{
+    private:
+        struct thread_cache;
+
+        // header stored before each block
+        struct alignas(std::max_align_t) block_header
+        {
+            thread_cache*       owner;
+        };
+
+        struct thread_cache
+        {
+            // blocks released by the owning thread
+            std::vector<block_header*>  m_free;
+
+            // blocks released by other threads; m_mutex protects m_remote
+            // and m_orphaned
+            std::mutex                  m_mutex;
+            std::vector<block_header*>  m_remote;
+            std::atomic<size_t>         m_remote_size;
+
+            // number of blocks allocated from the system and not yet 
+            // returned
+            std::atomic<size_t>         m_blocks;
+
+            // the owning thread has exited; the cache is deleted when
+            // last block is returned
+            bool                        m_orphaned;
+
+            thread_cache();
+        };
+
+        // orphans the cache of a thread, when this thread exits
+        struct cache_holder
+        {
+            thread_cache*               m_cache;
+
+            cache_holder();
+            ~cache_holder();
+        };
+
+    public:
+        // size of memory block including the header
+        static const size_t block_size  = sizeof(block_header) + sizeof(T);
+
+        // default limit of memory kept in one cache
+        static const size_t default_max_cached  = size_t(1) << 20;
+
+    private:
+        static std::atomic<size_t>      m_max_blocks;
+
+    public:
+        // return memory for an object of type T; throw std::bad_alloc if 
+        // memory cannot be allocated
+        static void*        allocate();
+
+        // release memory returned by allocate
+        static void         deallocate(void* ptr);
+
+        // release n blocks returned by allocate
+        static void         deallocate_batch(void** ptrs, size_t n);
+
+        // set maximum size in bytes of memory kept by a thread for reuse; 
+        // this limit is applied separately to blocks released by the owning
+        // thread and blocks released by other threads; default value is 1MB
+        static void         set_max_cached(size_t bytes);
+
+    private:
+        static thread_cache*    get_cache(bool create);
+        static block_header*    get_header(void* ptr);
+        static void*            get_block(block_header* header);
+
+        static void         release_local(thread_cache* cache, block_header* header);
+
+        // m_mutex of header->owner must be locked; return true if the owner
+        // must be deleted
+        static bool         release_remote(block_header* header);
+        static bool         release_to_system(block_header* header);
+};
+
+};
+
+#include "cyclic_rc/details/recycling_pool.inl"
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "cyclic_rc/details/obj_count.h"
+#include "cyclic_rc/details/object_pool.h"
 
 namespace cyclic_rc { namespace details
 {
@@ -31,6 +32,12 @@ class obj_count;
 template<class config>
 class collector;
 
+template<int type>
+struct trace_visitor;
+
+template<class T, class allocator>
+class cyclic_object;
+
 }}
 
 namespace cyclic_rc
@@ -42,6 +49,12 @@ struct is_multithreaded
     static const bool value = T::is_multithreaded;
 };
 
+template<typename T, bool multithread>
+class local_ptr;
+
+template<typename T, bool multithread>
+class field_ptr;
+
 // base class of objects, that can be managed by shared_ptr class
 // if multithread = true, then thread-safe version of the collector is 
 // used
@@ -55,7 +68,11 @@ class cyclic_rc_base
     public:
         static const bool is_multithreaded  = multithread;
 
+        // true if derived from acyclic_rc_base
+        static const bool is_acyclic_type   = false;
+
         using delete_func   = void (*)(void*);
+        using batch_delete_func = void (*)(void** ptrs, size_t n);
 
     private:
         counter_type        m_counter;
@@ -80,6 +97,21 @@ class cyclic_rc_base
         // function will be called
         virtual delete_func get_deleter() const { return default_deleter; };
 
+        // return a function used to release memory of many objects at once;
+        // garbage objects with the same deleter are released by one call of
+        // this function if nullptr is not returned; objects with the same 
+        // deleter must return the same batch deleter; on default nullptr is
+        // returned, i.e. deleter is called on every object
+        virtual batch_delete_func get_batch_deleter() const { return nullptr; };
+
+        // return number of bytes of memory owned by this object (including
+        // the object itself); collection is started when memory of objects 
+        // created by make_cyclic and of possible roots of cycles exceeds a 
+        // threshold set by shared_ptr::set_memory_threshold; returned value
+        // must not change during lifetime of the object; on default 0 is 
+        // returned, i.e. this object is not taken into account
+        virtual size_t      get_memory_size() const { return 0; };
+
     private:
         const counter_type& get_counter() const { return m_counter; };
         counter_type&       get_counter()       { return m_counter; };        
@@ -90,14 +122,74 @@ class cyclic_rc_base
         template<class T, bool mt>
         friend class shared_ptr;
 
+        template<class T, bool mt>
+        friend class field_ptr;
+
         template<class config>
         friend class details::obj_count;
 
+        template<class T, class allocator>
+        friend class details::cyclic_object;
+
+        // memory of objects created by make_cyclic is counted by 
+        // constructor and destructor of details::cyclic_object
+        static void         add_allocated(cyclic_rc_base* s);
+        static void         remove_allocated(cyclic_rc_base* s);
+
         static void default_deleter(void* ptr)
         {
             std::free(ptr);
             return;
         };
+
+        static void default_batch_deleter(void** ptrs, size_t n)
+        {
+            for (size_t i = 0; i < n; ++i)
+                std::free(ptrs[i]);
+        };
+};
+
+// base class of objects, that cannot be part of a cycle, i.e. cannot 
+// reference (directly or indirectly) objects of their own type; 
+// shared_ptr<T> with T derived from this class updates reference count
+// with one atomic operation and releases the object immediately, when 
+// reference count drops to zero, without taking the global lock and without
+// buffering possible roots; the collector does not traverse such objects;
+// long chains of acyclic objects are released recursively
+template<bool multithread>
+class acyclic_rc_base : public cyclic_rc_base<multithread>
+{
+    public:
+        static const bool is_acyclic_type   = true;
+
+    public:
+        // initialize reference counter to zero
+        acyclic_rc_base();
+};
+
+// base class of objects, that declare directly accessible objects by a
+// member function of Derived:
+//
+//      template<class Visitor>
+//      void trace(Visitor& v);
+//
+// which calls v(p) on every shared_ptr p stored in the object (the rules of
+// cyclic_rc_base::visit_children apply); trace is instantiated for each 
+// phase of the collection, therefore reference counters are updated by 
+// inlined code and only one virtual call per visited object is performed
+template<class Derived, bool multithread>
+class traced_rc_base : public cyclic_rc_base<multithread>
+{
+    public:
+        // initialize reference counter to zero; see cyclic_rc_base
+        traced_rc_base(bool is_acyclic = false);
+
+        // call Derived::trace with a visitor implementing given phase
+        virtual void        visit_children(int type) override final;
+
+    private:
+        template<details::collect_type type>
+        void                trace_phase();
 };
 
 // reference counting handling circular memory references
@@ -118,8 +210,8 @@ class cyclic_rc_base
 // Managed objects of type T must derive from class cyclic_rc_base<multithreaded>.
 // 
 // cyclic_rc::shared_ptr can work in multithreaded environment, however garbage
-// collection is blocking. When multithreaded = true, then multi-threaded version
-// is used. 
+// collection is blocking unless concurrent collector is enabled. When 
+// multithreaded = true, then multi-threaded version is used. 
 //
 // Collection algorithm is based on:
 //  "A Pure Reference Counting Garbage Collector",  DAVID F. BACON, CLEMENT R. 
@@ -170,6 +262,16 @@ class shared_ptr
         template<class Y>
         shared_ptr(shared_ptr<Y, multithread> && r);
 
+        // create shared_ptr from a handle declared in local_ptr.h; 
+        // reference counter is increased
+        template<class Y>
+        shared_ptr(const local_ptr<Y, multithread>& r);
+
+        // create shared_ptr from a field declared in field_ptr.h; reference 
+        // counter is increased
+        template<class Y>
+        shared_ptr(const field_ptr<Y, multithread>& r);
+
         // destructor; destructor of stored pointer is called, if reference
         // counter drops to zero (possibly after destroying all objects accessible
         // from stored pointed); destructor of stored pointer will be called
@@ -232,15 +334,116 @@ class shared_ptr
         // call visit_children function on all directly accessible objects
         void                visit_children(int type);
 
+        // static functions below control the collector of the default domain
+        // (domain 0); collectors of other domains of multithreaded objects
+        // are controlled by collector_domain
+
         // force collection of no longer accessible objects; if all = true, 
         // then destructors of all inaccessible objects will be called; 
         // otherwise some destructors may be delayed
         static void			collect(bool all);
 
+        // perform part of the collection; at most max_roots possible roots of
+        // cycles are processed; next call continues from the point, where this
+        // call stopped; return false if all possible roots found before the 
+        // current pass was started are already processed; collection started
+        // automatically when the number of possible roots exceeds a threshold
+        // is not affected
+        static bool         collect_step(size_t max_roots);
+
+        // perform part of the collection, that should take at most max_time;
+        // possible roots are processed and objects are released in small 
+        // portions until max_time is exceeded or current pass is finished; 
+        // other threads are stopped once for the whole call; return value is
+        // the same as in case of collect_step(size_t)
+        static bool         collect_step(std::chrono::microseconds max_time);
+
+        // start a thread, that performs collection when number of possible
+        // roots exceeds a threshold; since then threads modifying reference
+        // counters only signal this thread instead of running the collection;
+        // destructors of garbage objects are called in the collector thread;
+        // available only when multithread = true
+        static void         start_background_collector();
+
+        // stop the collector thread started by start_background_collector;
+        // since then collection is performed by threads modifying reference
+        // counters
+        static void         stop_background_collector();
+
+        // if concurrent = true, then collections started by collect function
+        // or by the background collector do not stop other threads during
+        // the trial deletion phase; other threads are stopped only for a short
+        // time, when possible roots are selected and when found garbage is
+        // validated and released; in this case visit_children can be called 
+        // while other threads modify the object, therefore visit_children 
+        // can only read shared_ptr members stored directly in the object;
+        // available only when multithread = true
+        static void         set_concurrent_collector(bool concurrent);
+
+        // set bounds of the number of possible roots, that starts collection
+        // automatically; the threshold grows if collections find little 
+        // garbage and shrinks if most of possible roots are garbage; if
+        // min_threshold = max_threshold, then the threshold is fixed; 
+        // default bounds are 500 and 500000
+        static void         set_collection_threshold(size_t min_threshold, 
+                                size_t max_threshold);
+
+        // current number of possible roots, that starts collection 
+        // automatically
+        static size_t       get_collection_threshold();
+
+        // start collection automatically when memory reported by 
+        // cyclic_rc_base::get_memory_size of live objects created by 
+        // make_cyclic grows by more than bytes since the last collection; 
+        // memory of objects marked as possible roots since the last 
+        // collection is also taken into account; if bytes = 0, then only the
+        // number of possible roots is taken into account; default value is
+        // 64MB
+        static void         set_memory_threshold(size_t bytes);
+
+        // when the collector processes buffers of possible roots, memory of
+        // a root distance positions ahead is prefetched; roots are usually 
+        // not stored in memory order, therefore large buffers are bound by
+        // cache misses; if distance = 0, then prefetching is disabled; 
+        // default value is 16
+        static void         set_prefetch_distance(size_t distance);
+
+        // if snapshot = true, then the collector copies state of all 
+        // possible roots in a buffer to a dense array before the buffer is
+        // filtered, and only roots that are removed or aged are accessed 
+        // again; default value is false
+        static void         set_root_snapshot(bool snapshot);
+
+        // number of possible roots processed, collections performed and
+        // objects freed by the collector of the domain 0
+        static collector_stats  get_collector_stats();
+
+        // use n_threads threads during trial deletion in large collections;
+        // if n_threads <= 1, then collection is performed by one thread; 
+        // available only when multithread = true and reference counters are
+        // updated without the global lock (CYCLIC_RC_MT_MODE other than
+        // CYCLIC_RC_MT_LOCKED), otherwise has no effect; visit_children can
+        // be called concurrently on different objects
+        static void         set_collector_threads(size_t n_threads);
+
+        // call destructors and deleters of garbage objects in n_threads 
+        // threads instead of the thread performing collection, which can 
+        // return before garbage is freed; all destructors in a batch are 
+        // called before deleters; if n_threads > 1, then destructors and 
+        // deleters can be called concurrently; collect(true) waits until
+        // all garbage is freed; if n_threads = 0 (default), then garbage is
+        // freed by the collecting thread; available only when 
+        // multithread = true
+        static void         set_free_threads(size_t n_threads);
+
     private:
         void                init();
         void                destroy(slot* p);
 
+        // visit_children inlined into traversals generated by 
+        // traced_rc_base
+        void                visit_child(int type);
+
     private:
         slot*               m_ptr;
 
@@ -263,6 +466,9 @@ class shared_ptr
 
         template<class T, bool multithread>
         friend class shared_ptr;
+
+        template<int type>
+        friend struct details::trace_visitor;
 };
 
 // exchange contents of other object and this object without altering
@@ -274,6 +480,21 @@ void swap(shared_ptr<T, multithread>& a, shared_ptr<T, multithread>& b)
     a.swap(b);
 }
 
+// create an object of type T managed by shared_ptr; args are passed to the
+// constructor of T; memory is allocated by allocator::allocate() and released
+// by allocator::deallocate(void*) or allocator::deallocate_batch(void**, 
+// size_t); deleters returned by T::get_deleter and T::get_batch_deleter are 
+// overridden
+template<class T, class allocator, class ... Args>
+shared_ptr<T> allocate_cyclic(Args&& ... args);
+
+// create an object of type T managed by shared_ptr; args are passed to the
+// constructor of T; memory of small objects is allocated from pools of blocks
+// of the same size and released in batches; deleters returned by 
+// T::get_deleter and T::get_batch_deleter are overridden
+template<class T, class ... Args>
+shared_ptr<T> make_cyclic(Args&& ... args);
+
 };
 
 #include "cyclic_rc/details/shared_ptr.inl"
@@ -0,0 +1,371 @@
+/* 
+ *  This file is a part of cyclic_rc library.
+ *
+ *  Copyright (c) Pawe Kowal 2017 - 2021
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "cyclic_rc/shared_ptr.h"
+#include "cyclic_rc/local_ptr.h"
+#include "cyclic_rc/field_ptr.h"
+#include "timer.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+
+using namespace cyclic_rc;
+using namespace cyclic_rc :: testing;
+
+#pragma warning(push)
+#pragma warning(disable: 4127) // conditional expression is constant
+
+namespace
+{
+
+// default prefetch distance of the collector
+const size_t default_distance   = 16;
+
+template<bool multithread>
+struct bench_node : cyclic_rc_base<multithread>
+{
+    shared_ptr<bench_node, multithread> next;
+
+    void visit_children(int t) override
+    {
+        next.visit_children(t);
+    };
+};
+
+// measure the time of a full collection of n_roots possible roots stored
+// in random order with respect to their addresses; all roots are alive,
+// therefore every root is marked, scanned and restored; nodes are linked
+// in pairs, longer chains would make every intermediate collection 
+// traverse the whole structure; if snapshot = true, then buffers are 
+// filtered with the root snapshot
+template<bool multithread>
+double bench_collect(size_t n_roots, size_t distance, bool snapshot)
+{
+    using node      = bench_node<multithread>;
+    using node_ptr  = shared_ptr<node, multithread>;
+
+    std::vector<node_ptr> nodes;
+    nodes.reserve(n_roots);
+
+    for (size_t i = 0; i < n_roots; ++i)
+        nodes.push_back(make_cyclic<node>());
+
+    std::vector<size_t> order(n_roots);
+    for (size_t i = 0; i < n_roots; ++i)
+        order[i] = i;
+
+    std::mt19937 gen(0);
+    std::shuffle(order.begin(), order.end(), gen);
+
+    for (size_t i = 0; i + 1 < n_roots; i += 2)
+        nodes[order[i]]->next = nodes[order[i + 1]];
+
+    {
+        // decrementing counts buffers every node as a possible root in 
+        // shuffled order
+        std::vector<node_ptr> copy;
+        copy.reserve(n_roots);
+
+        for (size_t i = 0; i < n_roots; ++i)
+            copy.push_back(nodes[order[i]]);
+    };
+
+    node_ptr::set_prefetch_distance(distance);
+    node_ptr::set_root_snapshot(snapshot);
+
+    timer t;
+    t.tic();
+    node_ptr::collect(true);
+    double time = t.toc();
+
+    node_ptr::set_prefetch_distance(default_distance);
+    node_ptr::set_root_snapshot(false);
+
+    for (size_t i = 0; i < n_roots; ++i)
+        nodes[i]->next = node_ptr();
+
+    nodes.clear();
+    node_ptr::collect(true);
+
+    return time;
+};
+
+template<bool multithread>
+void bench_prefetch()
+{
+    const size_t distances[]    = {0, default_distance};
+    const size_t sizes[]        = {100000, 1000000, 10000000};
+
+    for (size_t n_roots : sizes)
+    {
+        std::cout << "roots: " << n_roots;
+
+        for (size_t distance : distances)
+        {
+            double time = bench_collect<multithread>(n_roots, distance, false);
+            std::cout << ", distance " << distance << ": " << time * 1000.0
+                      << " ms";
+        };
+
+        std::cout << "\n";
+    };
+};
+
+template<bool multithread>
+void bench_snapshot()
+{
+    const size_t sizes[]        = {100000, 1000000, 10000000};
+
+    for (size_t n_roots : sizes)
+    {
+        double time_direct  = bench_collect<multithread>(n_roots, 
+                                default_distance, false);
+        double time_snap    = bench_collect<multithread>(n_roots, 
+                                default_distance, true);
+
+        std::cout << "roots: " << n_roots 
+                  << ", direct: " << time_direct * 1000.0 << " ms"
+                  << ", snapshot: " << time_snap * 1000.0 << " ms" << "\n";
+    };
+};
+
+// measure the time of n_passes traversals of a list of n_nodes nodes with a 
+// cursor of type Cursor; moving a shared_ptr cursor marks every visited 
+// node as a possible root
+template<class Cursor, bool multithread>
+double bench_traverse(size_t n_nodes, size_t n_passes)
+{
+    using node      = bench_node<multithread>;
+    using node_ptr  = shared_ptr<node, multithread>;
+
+    node_ptr first  = make_cyclic<node>();
+
+    {
+        node_ptr last   = first;
+
+        for (size_t i = 1; i < n_nodes; ++i)
+        {
+            last->next  = make_cyclic<node>();
+            last        = last->next;
+        };
+    };
+
+    timer t;
+    t.tic();
+
+    size_t n_visited    = 0;
+
+    for (size_t i = 0; i < n_passes; ++i)
+    {
+        for (Cursor p = first; p; p = p->next)
+            ++n_visited;
+    };
+
+    node_ptr::collect(true);
+    double time = t.toc();
+
+    if (n_visited != n_nodes * n_passes)
+        std::cout << "invalid traversal\n";
+
+    // list is released in a loop by the collector
+    first.reset();
+    node_ptr::collect(true);
+
+    return time;
+};
+
+template<bool multithread>
+void bench_local()
+{
+    using node      = bench_node<multithread>;
+    using node_ptr  = shared_ptr<node, multithread>;
+    using node_local= local_ptr<node, multithread>;
+
+    const size_t n_nodes    = 10000;
+    const size_t n_passes   = 1000;
+
+    double time_shared  = bench_traverse<node_ptr, multithread>(n_nodes, n_passes);
+    double time_local   = bench_traverse<node_local, multithread>(n_nodes, n_passes);
+
+    std::cout << "nodes: " << n_nodes << ", passes: " << n_passes 
+              << ", shared_ptr: " << time_shared * 1000.0 << " ms"
+              << ", local_ptr: " << time_local * 1000.0 << " ms" << "\n";
+};
+
+// measure the time of traversals of separate lists by n_threads threads; 
+// nodes are not shared, but cursors update counters synchronized in the
+// same way as counters of shared objects
+double bench_threads(size_t n_threads)
+{
+    using node      = bench_node<true>;
+    using node_ptr  = shared_ptr<node, true>;
+
+    const size_t n_nodes    = 1000;
+    const size_t n_passes   = 2000;
+
+    auto traverse   = [=]()
+    {
+        node_ptr first  = make_cyclic<node>();
+        node_ptr last   = first;
+
+        for (size_t i = 1; i < n_nodes; ++i)
+        {
+            last->next  = make_cyclic<node>();
+            last        = last->next;
+        };
+
+        for (size_t i = 0; i < n_passes; ++i)
+        {
+            for (node_ptr p = first; p; p = p->next)
+                ;
+        };
+    };
+
+    timer t;
+    t.tic();
+
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < n_threads; ++i)
+        threads.push_back(std::thread(traverse));
+
+    for (auto& th : threads)
+        th.join();
+
+    node_ptr::collect(true);
+    return t.toc();
+};
+
+void bench_contention()
+{
+    for (size_t n_threads = 1; n_threads <= 8; n_threads *= 2)
+    {
+        double time     = bench_threads(n_threads);
+
+        std::cout << "threads: " << n_threads << ", time: " 
+                  << time * 1000.0 << " ms" << "\n";
+    };
+};
+
+// node with a frequently modified member of type Field
+template<class Field, bool multithread>
+struct bench_holder : cyclic_rc_base<multithread>
+{
+    Field target;
+
+    void visit_children(int t) override
+    {
+        target.visit_children(t);
+    };
+};
+
+// measure the time of n_stores stores to members of n_holders objects, 
+// which point to one of n_targets objects
+template<class Field, bool multithread>
+double bench_stores(size_t n_holders, size_t n_targets, size_t n_stores)
+{
+    using node          = bench_node<multithread>;
+    using node_ptr      = shared_ptr<node, multithread>;
+    using holder        = bench_holder<Field, multithread>;
+    using holder_ptr    = shared_ptr<holder, multithread>;
+
+    std::vector<holder_ptr> holders;
+    std::vector<node_ptr> targets;
+
+    for (size_t i = 0; i < n_holders; ++i)
+        holders.push_back(make_cyclic<holder>());
+
+    for (size_t i = 0; i < n_targets; ++i)
+        targets.push_back(make_cyclic<node>());
+
+    timer t;
+    t.tic();
+
+    for (size_t i = 0; i < n_stores; ++i)
+        holders[i % n_holders]->target = targets[(i * 7) % n_targets];
+
+    node_ptr::collect(true);
+    double time = t.toc();
+
+    holders.clear();
+    targets.clear();
+    node_ptr::collect(true);
+
+    return time;
+};
+
+template<bool multithread>
+void bench_coalescing()
+{
+    using node      = bench_node<multithread>;
+    using node_ptr  = shared_ptr<node, multithread>;
+    using node_field= field_ptr<node, multithread>;
+
+    const size_t n_holders  = 1000;
+    const size_t n_targets  = 100;
+    const size_t n_stores   = 10000000;
+
+    double time_shared  = bench_stores<node_ptr, multithread>(n_holders, 
+                            n_targets, n_stores);
+    double time_field   = bench_stores<node_field, multithread>(n_holders, 
+                            n_targets, n_stores);
+
+    std::cout << "fields: " << n_holders << ", stores: " << n_stores
+              << ", shared_ptr: " << time_shared * 1000.0 << " ms"
+              << ", field_ptr: " << time_field * 1000.0 << " ms" << "\n";
+};
+
+}
+
+// benchmark of prefetching and snapshots during filtering of root buffers, of
+// traversals with local handles, of coalesced updates of fields and of 
+// counter updates by many threads
+void bench()
+{
+    std::cout << "\n" << "BENCHMARK: root prefetching, single-thread" << "\n";
+    bench_prefetch<false>();
+
+    std::cout << "\n" << "BENCHMARK: root prefetching, multi-thread" << "\n";
+    bench_prefetch<true>();
+
+    std::cout << "\n" << "BENCHMARK: root snapshot, single-thread" << "\n";
+    bench_snapshot<false>();
+
+    std::cout << "\n" << "BENCHMARK: root snapshot, multi-thread" << "\n";
+    bench_snapshot<true>();
+
+    std::cout << "\n" << "BENCHMARK: list traversal, single-thread" << "\n";
+    bench_local<false>();
+
+    std::cout << "\n" << "BENCHMARK: list traversal, multi-thread" << "\n";
+    bench_local<true>();
+
+    std::cout << "\n" << "BENCHMARK: field updates, single-thread" << "\n";
+    bench_coalescing<false>();
+
+    std::cout << "\n" << "BENCHMARK: traversals of unrelated lists, multi-thread" << "\n";
+    bench_contention();
+};
+
+#pragma warning(pop)
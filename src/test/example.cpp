@@ -49,7 +49,7 @@ struct tree : cyclic_rc_base<false>
 void example()
 {
     // create reference cycle
-    tree_ptr root = tree_ptr(new tree());
+    tree_ptr root = make_cyclic<tree>();
 
     root->left  = root;
     root->right = root;
@@ -22,6 +22,7 @@
 #include "obj.h"
 #include "timer.h"
 #include <iostream>
+#include <string>
 
 #include <thread>
 #include <functional>
@@ -33,6 +34,7 @@ using namespace cyclic_rc :: testing;
 #pragma warning(disable: 4127) // conditional expression is constant
 
 void example();
+void bench();
 
 template<bool multithread>
 void test_func()
@@ -66,6 +68,23 @@ void main_test()
 
     for (int i = 0; i < 10; ++i)
     {
+        if (i == 0)
+        {
+            test<multithread>::make_long_cycle(1000000);
+            test<multithread>::make_long_list(1000000);
+            test<multithread>::make_local_list(1000000);
+            test<multithread>::make_local_change(10000);
+            test<multithread>::make_freeing_updates(100000);
+            test<multithread>::make_freeing_fields(100000);
+            test<multithread>::make_freeing_release(100000);
+            test<multithread>::make_step_cycles(1000);
+            test<multithread>::make_step_time(100000);
+            test<multithread>::make_root_snapshot(10000);
+
+            if (multithread == true)
+                test<multithread>::make_domains(100000);
+        };
+
         {
             std::thread t1 = std::thread(std::function<void()>(&test_func<multithread>));
             std::thread t2; 
@@ -114,8 +133,11 @@ void main_test()
 
 int main(int argc, char* argv[])
 {    
-    (void)argc;
-    (void)argv;
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        bench();
+        return 0;
+    };
 
     example();
 
@@ -134,6 +156,34 @@ int main(int argc, char* argv[])
     std::cout << "\n" << "TESTING: multi-thread" << "\n";
     main_test<true>();
 
+    test<true>::make_foreign_release(10000);
+    test<true>::make_owner_exit(10000);
+    test<true>::make_exit_release(10000);
+
+    test<false>::make_memory_pressure(1000);
+    test<true>::make_memory_pressure(1000);
+
+    test<false>::make_adaptive_threshold(100000);
+    test<true>::make_adaptive_threshold(100000);
+
+    test<true>::make_parallel_collection(100000);
+
+    std::cout << "\n" << "TESTING: multi-thread, background collector" << "\n";
+    obj_ptr<true>::start_background_collector();
+    obj_ptr<true>::set_collector_threads(4);
+    main_test<true>();
+    obj_ptr<true>::set_collector_threads(1);
+
+    std::cout << "\n" << "TESTING: multi-thread, concurrent collector" << "\n";
+    obj_ptr<true>::set_concurrent_collector(true);
+    obj_ptr<true>::set_free_threads(2);
+    test<true>::make_concurrent_marking(1000);
+    main_test<true>();
+    obj_ptr<true>::set_free_threads(0);
+    obj_ptr<true>::set_concurrent_collector(false);
+
+    obj_ptr<true>::stop_background_collector();
+
     std::cout << "\n" << "finished" << "\n";
 	return 0;
 }
@@ -37,25 +37,6 @@ namespace cyclic_rc { namespace testing
 std::atomic<int> g_code = 0;
 std::atomic<int> g_count = 0;
 
-template<bool multithread>
-thread_local static
-typename obj<multithread>::obj_vec* pool_obj = nullptr;
-
-template<bool multithread>
-thread_local static
-typename obj<multithread>::count_vec* 
-pool_count = nullptr;
-
-template<bool multithread>
-typename obj<multithread>::obj_vec& 
-obj<multithread>::get_obj_vec()
-{
-    if (pool_obj<multithread> == nullptr)
-        pool_obj<multithread> = new obj_vec();
-
-    return *pool_obj<multithread>;
-};
-
 template<bool multithread>
 struct leak_detector
 {    
@@ -114,27 +95,7 @@ leak_detector<multithread>::get_set()
 template<bool multithread>
 obj<multithread>* obj<multithread>::create_obj()
 {    
-    obj* ret;
-
-    {
-        obj_vec& pool = get_obj_vec();
-
-        if (pool.size() > 0)
-        {
-            obj* ptr = pool.back();
-            pool.pop_back();       
-            ret = ptr;
-        }
-        else
-        {
-            ret = nullptr;
-        };
-    };
-
-    if (ret == nullptr)
-        ret = new obj();
-    else
-        new(ret) obj();
+    obj* ret = new(pool_type::allocate()) obj();
 
     #if DEBUG_RC
         ret->set_code(g_code);
@@ -147,25 +108,30 @@ obj<multithread>* obj<multithread>::create_obj()
 };
 
 template<bool multithread>
-void obj<multithread>::destroy_obj(obj* ptr)
+obj<multithread>::~obj()
 {
-    //delete ptr;
-
     #if DEBUG_RC
-        leak_detector<multithread>::report_delete(ptr);
+        leak_detector<multithread>::report_delete(this);
         --g_count;
     #endif
-
-    obj_vec& pool = get_obj_vec();       
-    pool.push_back(ptr);    
 };
 
+
 template<bool multithread>
-obj<multithread>::~obj()
+leaf<multithread>::leaf()
 {
-    destroy_obj(this);
+    #if DEBUG_RC
+        ++g_count;
+    #endif
 };
 
+template<bool multithread>
+leaf<multithread>::~leaf()
+{
+    #if DEBUG_RC
+        --g_count;
+    #endif
+};
 
 #if CYCLIC_RC_TEST
     template<bool multithread>
@@ -181,4 +147,7 @@ obj<multithread>::~obj()
 template class obj<false>;
 template class obj<true>;
 
+template class leaf<false>;
+template class leaf<true>;
+
 };}
\ No newline at end of file
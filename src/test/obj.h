@@ -21,6 +21,7 @@
 #pragma once 
 
 #include "cyclic_rc/shared_ptr.h"
+#include "cyclic_rc/recycling_pool.h"
 #include <vector>
 #include "boost/smart_ptr/detail/spinlock.hpp"
 
@@ -36,6 +37,12 @@ class obj;
 template<bool multithread>
 using obj_ptr   = cyclic_rc::shared_ptr<class obj<multithread>, multithread>;
 
+template<bool multithread>
+class leaf;
+
+template<bool multithread>
+using leaf_ptr  = cyclic_rc::shared_ptr<class leaf<multithread>, multithread>;
+
 class spinlock
 {
     private:
@@ -72,22 +79,39 @@ struct get_mutex<false>
     using type  = empty_mutex;
 };
 
+// object without children, released without the collector
+template<bool multithread>
+class leaf : public acyclic_rc_base<multithread>
+{
+    public:
+        leaf();
+        virtual ~leaf();
+
+        virtual void    visit_children(int op) override { (void)op; };
+};
+
 template<bool multithread>
-class obj : public cyclic_rc_base<multithread>
+class obj : public traced_rc_base<obj<multithread>, multithread>
 {
     public:
-        using obj_vec   = std::vector<obj*>;
         using obj_ptr   = cyclic_rc::shared_ptr<class obj<multithread>, multithread>;
+        using leaf_ptr  = cyclic_rc::shared_ptr<class leaf<multithread>, multithread>;
+        using pool_type = cyclic_rc::recycling_pool<obj>;
 
     public:
         obj_ptr         m_left;
         obj_ptr         m_right;        
+        leaf_ptr        m_leaf;
 
     public:
-        virtual void    visit_children(int op) override;
+        template<class Visitor>
+        void            trace(Visitor& v);
+
+        // memory of destroyed objects is reused later
+        virtual delete_func get_deleter() const override  { return &pool_type::deallocate; };
+        virtual batch_delete_func get_batch_deleter() const override { return &pool_type::deallocate_batch; };
 
-        // destroyed objects can be reused later
-        virtual delete_func get_deleter() const override  { return empty_del; };
+        virtual size_t      get_memory_size() const override { return sizeof(obj); };
 
     private:
         obj(){};
@@ -96,25 +120,21 @@ class obj : public cyclic_rc_base<multithread>
         virtual ~obj();
 
         static obj*         create_obj();
-        static void         destroy_obj(obj* ptr);
         
         #if CYCLIC_RC_TEST
             int             m_code;
             static size_t   n_counters();
             void            set_code(int code) { m_code = code; };
         #endif
-
-    private:
-        static obj_vec&     get_obj_vec();
-
-        static void         empty_del(void*)    { return; };
 };
 
 template<bool multithread>
-inline void obj<multithread>::visit_children(int val)
+template<class Visitor>
+inline void obj<multithread>::trace(Visitor& v)
 {
-    m_left.visit_children(val);
-    m_right.visit_children(val);
+    v(m_left);
+    v(m_right);
+    v(m_leaf);
 };
 
 };}
@@ -19,8 +19,18 @@
  */
 
 #include "test.h"
+#include "cyclic_rc/child_layout.h"
+#include "cyclic_rc/local_ptr.h"
+#include "cyclic_rc/field_ptr.h"
+#include "cyclic_rc/collector_domain.h"
 #include <iostream>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <chrono>
 
 namespace cyclic_rc { namespace testing
 {
@@ -39,6 +49,179 @@ class obj2 : public cyclic_rc_base<multithread>
         };
 };
 
+// node of a graph; counts destroyed objects
+template<bool multithread>
+class node : public cyclic_rc_base<multithread>
+{
+    public:
+        using node_ptr  = shared_ptr<node, multithread>;
+
+    public:
+        node_ptr                    m_next;
+        node_ptr                    m_other;
+
+        static std::atomic<size_t>  m_destroyed;
+
+    public:
+        ~node()
+        {
+            ++m_destroyed;
+        };
+
+        virtual void visit_children(int op) override
+        {
+            m_next.visit_children(op);
+            m_other.visit_children(op);
+        };
+};
+
+template<bool multithread>
+std::atomic<size_t> node<multithread>::m_destroyed(0);
+
+template<bool multithread>
+class obj3 : public layout_rc_base<obj3<multithread>, multithread>
+{
+    public:
+        using obj3_ptr  = shared_ptr<obj3, multithread>;
+        using obj_ptr   = testing::obj_ptr<multithread>;
+
+    public:
+        obj3_ptr                m_next;
+        std::vector<obj_ptr>    m_items;
+
+    public:
+        static const child_layout& get_layout()
+        {
+            static const child_layout layout =
+            {
+                CYCLIC_RC_CHILD(obj3, m_next),
+                CYCLIC_RC_CHILDREN(obj3, m_items)
+            };
+
+            return layout;
+        };
+};
+
+template<bool multithread>
+class obj4 : public traced_rc_base<obj4<multithread>, multithread>
+{
+    public:
+        using obj4_ptr  = shared_ptr<obj4, multithread>;
+        using obj_ptr   = testing::obj_ptr<multithread>;
+
+    public:
+        field_ptr<obj4, multithread>    m_next;
+        field_ptr<testing::obj<multithread>, multithread> m_item;
+
+    public:
+        template<class Visitor>
+        void trace(Visitor& v)
+        {
+            v(m_next);
+            v(m_item);
+        };
+};
+
+// object, whose destructor modifies its members
+template<bool multithread>
+class obj5 : public cyclic_rc_base<multithread>
+{
+    public:
+        using obj5_ptr  = shared_ptr<obj5, multithread>;
+
+    public:
+        obj5_ptr                    m_next;
+        obj5_ptr                    m_other;
+
+        static std::atomic<size_t>  m_destroyed;
+
+    public:
+        ~obj5()
+        {
+            // children of a garbage object can be already destroyed
+            m_other = m_next;
+            m_next.reset();
+            m_other.reset();
+
+            ++m_destroyed;
+        };
+
+        virtual void visit_children(int op) override
+        {
+            m_next.visit_children(op);
+            m_other.visit_children(op);
+        };
+};
+
+template<bool multithread>
+std::atomic<size_t> obj5<multithread>::m_destroyed(0);
+
+// object with fields modified by its destructor
+template<bool multithread>
+class obj6 : public cyclic_rc_base<multithread>
+{
+    public:
+        using obj6_ptr  = shared_ptr<obj6, multithread>;
+
+    public:
+        field_ptr<obj6, multithread>    m_next;
+        field_ptr<obj6, multithread>    m_other;
+
+        static std::atomic<size_t>      m_destroyed;
+
+    public:
+        ~obj6()
+        {
+            // values of fields can be already destroyed
+            m_other = m_next;
+            m_next.reset();
+
+            ++m_destroyed;
+        };
+
+        virtual void visit_children(int op) override
+        {
+            m_next.visit_children(op);
+            m_other.visit_children(op);
+        };
+};
+
+template<bool multithread>
+std::atomic<size_t> obj6<multithread>::m_destroyed(0);
+
+// object reporting a large amount of owned memory
+template<bool multithread>
+class obj7 : public cyclic_rc_base<multithread>
+{
+    public:
+        using obj7_ptr  = shared_ptr<obj7, multithread>;
+
+        static const size_t         memory_size = size_t(1) << 20;
+
+    public:
+        obj7_ptr                    m_next;
+
+        static std::atomic<size_t>  m_destroyed;
+
+    public:
+        ~obj7()
+        {
+            ++m_destroyed;
+        };
+
+        virtual size_t  get_memory_size() const override
+        {
+            return memory_size;
+        };
+
+        virtual void visit_children(int op) override
+        {
+            m_next.visit_children(op);
+        };
+};
+
+template<bool multithread>
+std::atomic<size_t> obj7<multithread>::m_destroyed(0);
 
 template <bool multithread>
 void test_compile()
@@ -54,6 +237,11 @@ void test_compile()
     obj* ptr            = obj::create_obj();
     obj_der* ptr_d      = (obj_der*)obj_der::create_obj();
 
+    // keep both objects alive until the end; otherwise these objects could
+    // be released at the end of the first block and then accessed again
+    obj_ptr owner(ptr);
+    obj_ptr owner_d(ptr_d);
+
     {
         obj_ptr tmp1;
         obj_ptr tmp2(nullptr);
@@ -104,6 +292,98 @@ void test_compile()
         p4      = std::move(p2);
     };
 
+    {
+        // children of a cycle described by child_layout must be released
+        using obj3_ptr  = typename obj3<multithread>::obj3_ptr;
+
+        obj3_ptr p1     = make_cyclic<obj3<multithread>>();
+        obj3_ptr p2     = make_cyclic<obj3<multithread>>();
+
+        p1->m_next      = p2;
+        p2->m_next      = p1;
+
+        p1->m_items.push_back(obj_ptr(obj::create_obj()));
+        p2->m_items.push_back(obj_ptr(obj::create_obj()));
+    };
+
+    {
+        // objects referenced by local handles must not be released, when
+        // the last counted reference is removed or during a collection
+        using obj_local     = local_ptr<obj, multithread>;
+
+        obj_ptr head(obj::create_obj());
+        head->m_left        = obj_ptr(obj::create_obj());
+        head->m_left->m_left= head;
+
+        obj_local next      = head->m_left;
+        obj_local tmp1;
+        obj_local tmp2(nullptr);
+        obj_local tmp3(tmp2);
+
+        head.reset();
+        next->m_left.reset();
+        obj_ptr::collect(true);
+
+        next->m_right       = obj_ptr(obj::create_obj());
+        tmp1                = next;
+        tmp3                = next->m_right;
+        tmp2                = tmp3;
+
+        bool val1           = (bool)tmp1;
+        bool val2           = !tmp2;
+        obj& ref1           = *tmp3;
+
+        (void)val1;
+        (void)val2;
+        (void)ref1;
+
+        obj_ptr owner2(tmp1);
+        tmp1.reset();
+        next.reset();
+    };
+
+    {
+        // fields modified many times between reconciliations; items 
+        // replaced in fields must be released, cycles must be collected
+        using obj4_ptr  = typename obj4<multithread>::obj4_ptr;
+
+        std::vector<obj4_ptr> nodes;
+        std::vector<obj_ptr> items;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            nodes.push_back(make_cyclic<obj4<multithread>>());
+            items.push_back(obj_ptr(obj::create_obj()));
+        };
+
+        for (int i = 0; i < 10000; ++i)
+        {
+            nodes[i % 100]->m_next  = nodes[(i * 7) % 100];
+            nodes[i % 100]->m_item  = items[(i * 13) % 100];
+
+            if (i % 1000 == 0)
+                obj_ptr::collect(false);
+        };
+
+        field_ptr<obj4<multithread>, multithread> f1(nodes[0]);
+        field_ptr<obj4<multithread>, multithread> f2(f1);
+        field_ptr<obj4<multithread>, multithread> f3(nullptr);
+
+        f3              = f2;
+        f2.reset();
+
+        obj4_ptr p1     = f3;
+        bool val1       = (bool)f1;
+        bool val2       = !f2;
+
+        (void)val1;
+        (void)val2;
+
+        items.clear();
+        nodes.clear();
+        obj_ptr::collect(true);
+    };
+
     obj_ptr::collect(true);
 };
 
@@ -170,6 +450,8 @@ void test<multithread>::make(int n_operations)
 
         if (make_clear_all() == true)
             op_clear_all();
+        else if (i % n_step == 0)
+            op_collect_step(i);
     };
 };
 
@@ -354,7 +636,13 @@ void test<multithread>::op_change()
 
     obj_ptr op(obj::create_obj());
 
+    // acyclic object is shared by the old and the new object
     int pos1                    = rand_pos();
+    op->m_leaf                  = m_obj_vector[pos1]->m_leaf;
+
+    if (!op->m_leaf)
+        op->m_leaf              = cyclic_rc::make_cyclic<leaf<multithread>>();
+
     m_obj_vector[pos1]          = op;
 }
 
@@ -417,6 +705,823 @@ void test<multithread>::op_clear_all()
     obj_ptr::collect(true);
 };
 
+template <bool multithread>
+void test<multithread>::op_collect_step(int i)
+{
+    if ((i / n_step) % 2 == 0)
+        obj_ptr::collect_step(size_t(100));
+    else
+        obj_ptr::collect_step(std::chrono::microseconds(50));
+};
+
+template <bool multithread>
+void test<multithread>::make_long_cycle(int n)
+{
+    // collector must not use recursion on long chains of objects
+    create_cycle(n);
+    obj_ptr::collect(true);
+};
+
+template <bool multithread>
+void test<multithread>::create_cycle(int n)
+{
+    obj_ptr first(obj::create_obj());
+    obj_ptr last    = first;
+
+    for (int i = 1; i < n; ++i)
+    {
+        obj_ptr o(obj::create_obj());
+        last->m_left    = o;
+        last            = o;
+    };
+
+    last->m_left    = first;
+
+    first.reset();
+    last.reset();
+};
+
+template <bool multithread>
+void test<multithread>::make_freeing_updates(int n)
+{
+    // destructors of garbage objects must not change counters of other 
+    // garbage objects
+    using obj5_ptr  = typename obj5<multithread>::obj5_ptr;
+
+    size_t n_destroyed  = obj5<multithread>::m_destroyed;
+
+    {
+        obj5_ptr first  = make_cyclic<obj5<multithread>>();
+        obj5_ptr last   = first;
+
+        for (int i = 1; i < n; ++i)
+        {
+            obj5_ptr o      = make_cyclic<obj5<multithread>>();
+            last->m_next    = o;
+            last->m_other   = first;
+            last            = o;
+        };
+
+        last->m_next    = first;
+    };
+
+    obj5_ptr::collect(true);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + n)
+        std::cout << "invalid collection of objects modified by destructors!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_step_cycles(int n)
+{
+    // each step processes one possible root, therefore second object of 
+    // a garbage cycle remains in the old buffer
+    using obj5_ptr  = typename obj5<multithread>::obj5_ptr;
+
+    obj5_ptr::collect(true);
+
+    size_t n_destroyed  = obj5<multithread>::m_destroyed;
+
+    for (int i = 0; i < n; ++i)
+    {
+        obj5_ptr a      = make_cyclic<obj5<multithread>>();
+        obj5_ptr b      = make_cyclic<obj5<multithread>>();
+        a->m_next       = b;
+        b->m_next       = a;
+    };
+
+    for (int i = 0; i < 100 * n; ++i)
+    {
+        if (obj5<multithread>::m_destroyed == n_destroyed + 2 * n)
+            break;
+
+        obj5_ptr::collect_step(size_t(1));
+    };
+
+    obj5_ptr::collect(true);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + 2 * n)
+        std::cout << "invalid collection of cycles by collect_step!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_root_snapshot(int n)
+{
+    // live cycles are buffered together with garbage cycles; roots pass 
+    // through all buffers in steps, only garbage can be destroyed
+    using obj5_ptr  = typename obj5<multithread>::obj5_ptr;
+
+    obj5_ptr::collect(true);
+    obj5_ptr::set_root_snapshot(true);
+
+    size_t n_destroyed  = obj5<multithread>::m_destroyed;
+
+    std::vector<obj5_ptr> live;
+
+    for (int i = 0; i < n; ++i)
+    {
+        obj5_ptr a      = make_cyclic<obj5<multithread>>();
+        obj5_ptr b      = make_cyclic<obj5<multithread>>();
+        a->m_next       = b;
+        b->m_next       = a;
+
+        obj5_ptr c      = make_cyclic<obj5<multithread>>();
+        obj5_ptr d      = make_cyclic<obj5<multithread>>();
+        c->m_next       = d;
+        d->m_next       = c;
+
+        live.push_back(c);
+    };
+
+    for (int i = 0; i < 100 * n; ++i)
+    {
+        if (obj5<multithread>::m_destroyed == n_destroyed + 2 * n)
+            break;
+
+        obj5_ptr::collect_step(size_t(10));
+    };
+
+    obj5_ptr::collect(true);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + 2 * n)
+        std::cout << "invalid collection of cycles with root snapshot!\n";
+
+    live.clear();
+    obj5_ptr::collect(true);
+    obj5_ptr::set_root_snapshot(false);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + 4 * n)
+        std::cout << "memory leaks in root snapshot test!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_step_time(int n)
+{
+    // garbage cycles are collected by steps limited by time; a step can
+    // exceed the limit only by the time of processing a small portion of 
+    // roots; some steps can be delayed by the scheduler or by waiting for 
+    // the global lock, therefore only most steps must meet the limit
+    using obj5_ptr  = typename obj5<multithread>::obj5_ptr;
+    using clock     = std::chrono::steady_clock;
+
+    const std::chrono::microseconds max_time(200);
+    const std::chrono::microseconds max_delay(5000);
+
+    obj5_ptr::collect(true);
+    obj5_ptr::set_collection_threshold(1000000, 1000000);
+
+    size_t n_destroyed  = obj5<multithread>::m_destroyed;
+
+    for (int i = 0; i < n; ++i)
+    {
+        obj5_ptr a      = make_cyclic<obj5<multithread>>();
+        obj5_ptr b      = make_cyclic<obj5<multithread>>();
+        a->m_next       = b;
+        b->m_next       = a;
+    };
+
+    int n_steps         = 0;
+    int n_delayed       = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        if (obj5<multithread>::m_destroyed == n_destroyed + 2 * n)
+            break;
+
+        clock::time_point start = clock::now();
+        obj5_ptr::collect_step(max_time);
+
+        ++n_steps;
+
+        if (clock::now() - start > max_time + max_delay)
+            ++n_delayed;
+    };
+
+    if (n_delayed * 4 > n_steps)
+        std::cout << "collect_step exceeded time limit!\n";
+
+    obj5_ptr::collect(true);
+    obj5_ptr::set_collection_threshold(500, 500000);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + 2 * n)
+        std::cout << "invalid collection of cycles by timed collect_step!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_freeing_release(int n)
+{
+    // destructors called while the release queue is drained drop references
+    // to a live object; its counter must not be decreased twice
+    using obj5_ptr  = typename obj5<multithread>::obj5_ptr;
+
+    size_t n_destroyed  = obj5<multithread>::m_destroyed;
+    obj5_ptr keep       = make_cyclic<obj5<multithread>>();
+
+    {
+        obj5_ptr first  = make_cyclic<obj5<multithread>>();
+        obj5_ptr last   = first;
+
+        for (int i = 1; i < n; ++i)
+        {
+            obj5_ptr o      = make_cyclic<obj5<multithread>>();
+            last->m_next    = o;
+            last->m_other   = keep;
+            last            = o;
+        };
+    };
+
+    obj5_ptr::collect(true);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + n)
+        std::cout << "invalid release of objects modified by destructors!\n";
+
+    if (keep.use_count() != 1)
+        std::cout << "invalid counter of object referenced by released objects!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_freeing_fields(int n)
+{
+    // fields of garbage objects must not log updates released later by
+    // the reconciliation
+    using obj6_ptr  = typename obj6<multithread>::obj6_ptr;
+
+    size_t n_destroyed  = obj6<multithread>::m_destroyed;
+
+    {
+        obj6_ptr first  = make_cyclic<obj6<multithread>>();
+        obj6_ptr last   = first;
+
+        for (int i = 1; i < n; ++i)
+        {
+            obj6_ptr o      = make_cyclic<obj6<multithread>>();
+            last->m_next    = o;
+            last->m_other   = first;
+            last            = o;
+        };
+
+        last->m_next    = first;
+    };
+
+    obj6_ptr::collect(true);
+
+    if (obj6<multithread>::m_destroyed != n_destroyed + n)
+        std::cout << "invalid collection of objects with fields!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_domains(int n)
+{
+    // collection in one domain must not release garbage of other domains
+
+    // domains are not available on 32-bit builds
+    if (collector_domain::max_domains < 3)
+        return;
+
+    collector_domain domain_1;
+    collector_domain domain_2;
+
+    // release remaining garbage of the default domain
+    obj_ptr::collect(true);
+
+    #if CYCLIC_RC_TEST
+        size_t n_start  = obj::n_counters();
+    #endif
+
+    {
+        collector_domain::scope scope(domain_2);
+        create_cycle(n);
+    };
+
+    #if CYCLIC_RC_TEST
+        size_t n_domain_2   = obj::n_counters();
+    #endif
+
+    {
+        collector_domain::scope scope(domain_1);
+        create_cycle(n);
+    };
+
+    domain_1.collect(true);
+
+    #if CYCLIC_RC_TEST
+        if (obj::n_counters() != n_domain_2)
+            std::cout << "invalid collection of domains!\n";
+    #endif
+
+    if (domain_1.get_stats().freed == 0 || domain_1.get_stats().collections == 0
+        || domain_2.get_stats().freed != 0)
+    {
+        std::cout << "invalid statistics of domains!\n";
+    };
+
+    domain_2.collect(true);
+
+    #if CYCLIC_RC_TEST
+        if (obj::n_counters() != n_start)
+            std::cout << "memory leaks in domains!\n";
+    #endif
+};
+
+template <bool multithread>
+void test<multithread>::make_concurrent_marking(int n)
+{
+    // objects of a live cycle are reordered while the concurrent collector
+    // marks the graph; an object is often referenced only by an edge 
+    // modified after the collector read it; small cycles selected as roots 
+    // become garbage during trial deletion
+    using obj5_ptr  = typename obj5<multithread>::obj5_ptr;
+
+    const int n_slots   = 16;
+
+    size_t n_destroyed  = obj5<multithread>::m_destroyed;
+    size_t n_created    = n;
+    obj5_ptr head       = make_cyclic<obj5<multithread>>();
+
+    {
+        obj5_ptr last   = head;
+
+        for (int i = 1; i < n; ++i)
+        {
+            obj5_ptr o      = make_cyclic<obj5<multithread>>();
+            last->m_next    = o;
+            last            = o;
+        };
+
+        last->m_next    = head;
+    };
+
+    std::vector<obj5_ptr> slots(n_slots);
+    std::atomic<bool> stop(false);
+
+    std::thread collector_thread([&stop]()
+    {
+        while (stop.load() == false)
+            obj5_ptr::collect(false);
+    });
+
+    for (int i = 0; i < 100 * n; ++i)
+    {
+        // head -> a -> b -> c is changed to head -> b -> a -> c
+        obj5_ptr a      = head->m_next;
+        obj5_ptr b      = a->m_next;
+
+        if (b.get() != head.get())
+        {
+            a->m_next       = b->m_next;
+            b->m_next       = a;
+            head->m_next    = b;
+
+            if (i % 7 == 0)
+                head        = b;
+        };
+
+        // copy of the slot is dropped, therefore the cycle becomes a 
+        // possible root; the cycle is released later
+        obj5_ptr& slot  = slots[i % n_slots];
+
+        if (i % (5 * n_slots) < n_slots)
+        {
+            slot            = make_cyclic<obj5<multithread>>();
+            slot->m_next    = make_cyclic<obj5<multithread>>();
+            slot->m_next->m_next    = slot;
+            n_created       += 2;
+        }
+        else
+        {
+            obj5_ptr tmp    = slot;
+        };
+    };
+
+    stop.store(true);
+    collector_thread.join();
+
+    int length          = 1;
+
+    for (obj5_ptr o = head->m_next; o.get() != head.get(); o = o->m_next)
+        ++length;
+
+    if (length != n)
+        std::cout << "live objects collected by concurrent collector!\n";
+
+    head.reset();
+    slots.clear();
+    obj5_ptr::collect(true);
+
+    if (obj5<multithread>::m_destroyed != n_destroyed + n_created)
+        std::cout << "memory leaks in concurrent marking!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_memory_pressure(int n)
+{
+    // garbage cycles must be collected when reported memory exceeds the
+    // threshold, before the number of possible roots reaches its threshold
+    using obj7_ptr  = typename obj7<multithread>::obj7_ptr;
+
+    const size_t n_cycles_limit = 8;
+
+    obj7_ptr::collect(true);
+    obj7_ptr::set_collection_threshold(size_t(10) * n, size_t(10) * n);
+    obj7_ptr::set_memory_threshold(2 * n_cycles_limit * obj7<multithread>::memory_size);
+
+    size_t n_destroyed  = obj7<multithread>::m_destroyed;
+    size_t n_created    = 0;
+    size_t max_live     = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        obj7_ptr a      = make_cyclic<obj7<multithread>>();
+        obj7_ptr b      = make_cyclic<obj7<multithread>>();
+        a->m_next       = b;
+        b->m_next       = a;
+        n_created       += 2;
+
+        size_t n_live   = n_created - (obj7<multithread>::m_destroyed - n_destroyed);
+        max_live        = std::max(max_live, n_live);
+    };
+
+    // possible roots are collected after aging in buffers, therefore several
+    // collections are required; without the memory threshold all objects 
+    // would be alive
+    if (max_live > n_created / 4)
+        std::cout << "collection not started by memory threshold!\n";
+
+    obj7_ptr::collect(true);
+    obj7_ptr::set_collection_threshold(500, 500000);
+    obj7_ptr::set_memory_threshold(size_t(64) << 20);
+
+    if (obj7<multithread>::m_destroyed != n_destroyed + n_created)
+        std::cout << "memory leaks in memory threshold test!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_adaptive_threshold(int n)
+{
+    // possible roots created by releasing handles to live objects are not
+    // garbage, therefore collections are unproductive; roots created by
+    // garbage cycles are all freed
+    using node_ptr  = typename node<multithread>::node_ptr;
+
+    node_ptr::collect(true);
+    node_ptr::set_collection_threshold(500, 500000);
+
+    size_t threshold_0  = node_ptr::get_collection_threshold();
+
+    std::vector<node_ptr> live;
+    for (int i = 0; i < n; ++i)
+        live.push_back(node_ptr(new node<multithread>()));
+
+    for (int k = 0; k < 50; ++k)
+    {
+        for (int i = 0; i < n; ++i)
+            node_ptr tmp = live[i];
+    };
+
+    size_t threshold_1  = node_ptr::get_collection_threshold();
+
+    if (threshold_1 <= threshold_0)
+        std::cout << "collection threshold not increased!\n";
+
+    live.clear();
+    node_ptr::collect(true);
+
+    size_t n_destroyed  = node<multithread>::m_destroyed;
+    size_t n_created    = 0;
+
+    for (int i = 0; i < 100 * n; ++i)
+    {
+        if (node_ptr::get_collection_threshold() < threshold_1)
+            break;
+
+        node_ptr a(new node<multithread>());
+        node_ptr b(new node<multithread>());
+        a->m_next       = b;
+        b->m_next       = a;
+        n_created       += 2;
+    };
+
+    size_t threshold_2  = node_ptr::get_collection_threshold();
+
+    if (threshold_2 >= threshold_1)
+        std::cout << "collection threshold not decreased!\n";
+
+    node_ptr::collect(true);
+    node_ptr::set_collection_threshold(500, 500000);
+
+    if (node<multithread>::m_destroyed != n_destroyed + n_created)
+        std::cout << "memory leaks in adaptive threshold test!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_parallel_collection(int n)
+{
+    // the graph is built from blocks of objects linked randomly inside the
+    // block; one object of every fourth block is kept alive; objects not 
+    // reachable from kept objects are garbage; collector threads require
+    // multithreaded objects
+    using node_ptr  = typename node<true>::node_ptr;
+
+    const int block_size    = 100;
+
+    auto collect_graph = [n, block_size](size_t n_threads, size_t& n_live) -> size_t
+    {
+        std::minstd_rand gen(1);
+
+        std::vector<node_ptr> nodes;
+        std::vector<node_ptr> keep;
+
+        for (int i = 0; i < n; ++i)
+            nodes.push_back(node_ptr(new node<true>()));
+
+        for (int i = 0; i < n; ++i)
+        {
+            int first   = i - i % block_size;
+            int size    = std::min(block_size, n - first);
+
+            nodes[i]->m_next    = nodes[first + gen() % size];
+
+            if (gen() % 2 == 0)
+                nodes[i]->m_other   = nodes[first + gen() % size];
+
+            if (i % (4 * block_size) == 0)
+                keep.push_back(nodes[i]);
+        };
+
+        // count objects reachable from kept objects
+        std::set<node<true>*> live;
+        std::vector<node<true>*> stack;
+
+        for (const auto& ptr : keep)
+            stack.push_back(ptr.get());
+
+        while (stack.empty() == false)
+        {
+            node<true>* o = stack.back();
+            stack.pop_back();
+
+            if (o == nullptr || live.insert(o).second == false)
+                continue;
+
+            stack.push_back(o->m_next.get());
+            stack.push_back(o->m_other.get());
+        };
+
+        n_live              = live.size();
+
+        node_ptr::collect(true);
+        node_ptr::set_collector_threads(n_threads);
+
+        size_t n_destroyed  = node<true>::m_destroyed;
+
+        nodes.clear();
+        node_ptr::collect(true);
+
+        size_t n_freed      = node<true>::m_destroyed - n_destroyed;
+
+        node_ptr::set_collector_threads(1);
+
+        // kept objects must be intact
+        size_t n_found      = 0;
+        for (const auto& ptr : keep)
+        {
+            if (ptr->m_next.get() != nullptr)
+                ++n_found;
+        };
+
+        if (n_found != keep.size())
+            std::cout << "live object destroyed by collection!\n";
+
+        keep.clear();
+        node_ptr::collect(true);
+
+        return n_freed;
+    };
+
+    size_t n_live_serial    = 0;
+    size_t n_live_parallel  = 0;
+    size_t n_freed_serial   = collect_graph(1, n_live_serial);
+    size_t n_freed_parallel = collect_graph(4, n_live_parallel);
+
+    if (n_freed_serial != size_t(n) - n_live_serial)
+        std::cout << "invalid serial collection!\n";
+
+    if (n_freed_parallel != n_freed_serial || n_live_parallel != n_live_serial)
+        std::cout << "invalid parallel collection!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_foreign_release(int n)
+{
+    // in CYCLIC_RC_MT_BIASED mode references created by this thread are
+    // counted by the biased counter; other thread must merge counters 
+    // before dropping the last reference
+    using node_ptr  = typename node<multithread>::node_ptr;
+
+    node_ptr::collect(true);
+
+    size_t n_destroyed  = node<multithread>::m_destroyed;
+
+    std::vector<node_ptr> objects;
+    std::vector<node_ptr> shared;
+
+    for (int i = 0; i < n; ++i)
+        objects.push_back(make_cyclic<node<multithread>>());
+
+    // second half of objects forms garbage cycles of two objects
+    for (int i = n / 2; i + 1 < n; i += 2)
+    {
+        objects[i]->m_next      = objects[i + 1];
+        objects[i + 1]->m_next  = objects[i];
+    };
+
+    // objects referenced by both threads
+    for (int i = 0; i < n; i += 10)
+        shared.push_back(objects[i]);
+
+    std::thread other([&objects, &shared]()
+    {
+        std::vector<node_ptr> copies(shared);
+        objects.clear();
+        copies.clear();
+    });
+
+    other.join();
+
+    // members of cycles are also referenced by the other member
+    for (const auto& ptr : shared)
+    {
+        size_t count    = (ptr->m_next.get() != nullptr) ? 2 : 1;
+
+        if (ptr.use_count() != count)
+            std::cout << "invalid counter of shared object!\n";
+    };
+
+    shared.clear();
+    node_ptr::collect(true);
+
+    if (node<multithread>::m_destroyed != n_destroyed + n)
+        std::cout << "memory leaks in foreign release test!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_owner_exit(int n)
+{
+    // references counted by a thread, that has exited, are released by 
+    // this thread
+    using node_ptr  = typename node<multithread>::node_ptr;
+
+    node_ptr::collect(true);
+
+    size_t n_destroyed  = node<multithread>::m_destroyed;
+
+    std::vector<node_ptr> objects;
+
+    std::thread owner([&objects, n]()
+    {
+        for (int i = 0; i < n; ++i)
+            objects.push_back(make_cyclic<node<multithread>>());
+
+        for (int i = n / 2; i + 1 < n; i += 2)
+        {
+            objects[i]->m_next      = objects[i + 1];
+            objects[i + 1]->m_next  = objects[i];
+        };
+    });
+
+    owner.join();
+
+    for (int i = 0; i < n; i += 2)
+    {
+        node_ptr tmp    = objects[i];
+        objects[i].reset();
+    };
+
+    objects.clear();
+    node_ptr::collect(true);
+
+    if (node<multithread>::m_destroyed != n_destroyed + n)
+        std::cout << "memory leaks in owner exit test!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_exit_release(int n)
+{
+    // the thread-local vector is created before the thread is registered in
+    // mutator_lock, therefore it is destroyed after the thread has been 
+    // unregistered; its references are released by the exiting thread
+    using node_ptr  = typename node<multithread>::node_ptr;
+
+    node_ptr::collect(true);
+
+    size_t n_destroyed  = node<multithread>::m_destroyed;
+
+    std::thread exiting([n]()
+    {
+        static thread_local std::vector<node_ptr> objects;
+
+        for (int i = 0; i < n; ++i)
+            objects.push_back(make_cyclic<node<multithread>>());
+
+        for (int i = n / 2; i + 1 < n; i += 2)
+        {
+            objects[i]->m_next      = objects[i + 1];
+            objects[i + 1]->m_next  = objects[i];
+        };
+    });
+
+    exiting.join();
+    node_ptr::collect(true);
+
+    if (node<multithread>::m_destroyed != n_destroyed + n)
+        std::cout << "memory leaks in thread exit test!\n";
+};
+
+template <bool multithread>
+void test<multithread>::make_long_list(int n)
+{
+    // objects must not be released recursively
+    obj_ptr first(obj::create_obj());
+    obj_ptr last    = first;
+
+    for (int i = 1; i < n; ++i)
+    {
+        obj_ptr o(obj::create_obj());
+        last->m_left    = o;
+        last            = o;
+    };
+
+    last.reset();
+    first.reset();
+};
+
+template <bool multithread>
+void test<multithread>::make_local_list(int n)
+{
+    // the list is built through a local handle, that does not change 
+    // reference counters; the list is released when the handle still 
+    // references its last object
+    using obj_local = local_ptr<obj, multithread>;
+
+    obj_ptr first(obj::create_obj());
+    obj_local last  = first;
+
+    for (int i = 1; i < n; ++i)
+    {
+        obj_ptr o(obj::create_obj());
+        last->m_left    = o;
+        last            = o;
+    };
+
+    first.reset();
+    last.reset();
+};
+
+template <bool multithread>
+void test<multithread>::make_local_change(int n)
+{
+    // objects of a cycle are replaced while accessed through local handles;
+    // count of a replaced object drops to zero while a handle exists
+    using obj_local = local_ptr<obj, multithread>;
+
+    obj_ptr::collect(true);
+
+    #if CYCLIC_RC_TEST
+        size_t n_start  = obj::n_counters();
+    #endif
+
+    {
+        obj_vector objects;
+
+        for (int i = 0; i < n; ++i)
+            objects.push_back(obj_ptr(obj::create_obj()));
+
+        for (int i = 0; i < n; ++i)
+            objects[i]->m_left  = objects[(i + 1) % n];
+
+        for (int i = 0; i < n; ++i)
+        {
+            obj_ptr op(obj::create_obj());
+            obj_local old       = objects[i];
+            op->m_leaf          = old->m_leaf;
+
+            if (!op->m_leaf)
+                op->m_leaf      = cyclic_rc::make_cyclic<leaf<multithread>>();
+
+            objects[i]          = op;
+            op->m_left          = old->m_left;
+            op->m_right         = old;
+        };
+    };
+
+    obj_ptr::collect(true);
+
+    #if CYCLIC_RC_TEST
+        if (obj::n_counters() != n_start)
+            std::cout << "memory leaks in local handles test!\n";
+    #endif
+};
+
 template class test<false>;
 template class test<true>;
 
@@ -52,6 +52,9 @@ class test
         //static const unsigned N   = 500000;
         static const unsigned N     = 5000000;       
 
+        // number of operations between calls to collect_step
+        static const int n_step     = 1000;
+
     private:
         using obj_ptr       = obj_ptr<multithread>;
         using obj           = obj<multithread>;
@@ -62,6 +65,73 @@ class test
         void            make(int n_operations);
         static void     clear_global();
 
+        // create a cycle of n objects and collect it
+        static void     make_long_cycle(int n);
+
+        // create a list of n objects and release it
+        static void     make_long_list(int n);
+
+        // create a list of n objects through a local handle and release it
+        static void     make_local_list(int n);
+
+        // replace objects of a cycle of n objects accessed through local 
+        // handles
+        static void     make_local_change(int n);
+
+        // release handles to n live objects, then create garbage cycles; 
+        // the collection threshold must grow and then shrink
+        static void     make_adaptive_threshold(int n);
+
+        // collect the same random graph of n objects by one thread and by
+        // several threads; both collections must free the same objects
+        static void     make_parallel_collection(int n);
+
+        // create n objects and release them by another thread; the last
+        // reference to some objects is counted by the creating thread
+        static void     make_foreign_release(int n);
+
+        // create n objects by a thread, that exits before these objects
+        // are released
+        static void     make_owner_exit(int n);
+
+        // create n objects referenced by a thread-local variable, that is 
+        // destroyed when the thread exits
+        static void     make_exit_release(int n);
+
+        // collect a cycle of n objects, whose destructors reset and assign
+        // their members
+        static void     make_freeing_updates(int n);
+
+        // collect a cycle of n objects linked by field_ptr members, that
+        // are modified by destructors
+        static void     make_freeing_fields(int n);
+
+        // collect n garbage cycles by steps processing one possible root
+        static void     make_step_cycles(int n);
+
+        // collect n garbage cycles by steps limited by time
+        static void     make_step_time(int n);
+
+        // collect n garbage cycles mixed with n live cycles, when buffers
+        // are filtered with the root snapshot
+        static void     make_root_snapshot(int n);
+
+        // release a list of n objects, whose destructors drop references
+        // to a live object
+        static void     make_freeing_release(int n);
+
+        // create garbage cycles of n objects in two collector domains and
+        // collect domains separately
+        static void     make_domains(int n);
+
+        // create n garbage cycles of objects reporting large memory with 
+        // the memory threshold set
+        static void     make_memory_pressure(int n);
+
+        // modify a live cycle of n objects while the concurrent collector
+        // is running
+        static void     make_concurrent_marking(int n);
+
     private:
         operation_type  rand_op();
         int             rand_pos();
@@ -81,12 +151,16 @@ class test
         void            op_load_global();
         void            op_delete_global();
         void            op_clear_all();
+        void            op_collect_step(int i);
 
         bool            do_global() const;
 
         static void     store_global(const obj_ptr& obj);
         static obj_ptr  load_global();
 
+        // create a cycle of n objects, that is not referenced
+        static void     create_cycle(int n);
+
     private:
         obj_vector          m_obj_vector;
         static obj_vector   m_obj_vector_global;
@@ -0,0 +1,33 @@
+@echo off
+rem builds the solution and runs tests for all values of CYCLIC_RC_MT_MODE
+rem (locked, lock-free, biased and striped counters); must be called from
+rem the developer command prompt; usage: test_mt_modes [configuration]
+rem [platform], default configuration is Release, default platform is x64
+
+setlocal
+
+set CONFIG=%1
+set PLATFORM=%2
+if "%CONFIG%"=="" set CONFIG=Release
+if "%PLATFORM%"=="" set PLATFORM=x64
+
+cd /d "%~dp0"
+
+for %%m in (0 1 2 3) do (
+    echo mode %%m
+
+    msbuild cyclic_rc.sln /m /v:minimal /p:Configuration=%CONFIG% /p:Platform=%PLATFORM% /p:CyclicRcMtMode=%%m
+    if errorlevel 1 exit /b 1
+
+    "%PLATFORM%\%CONFIG%-mt%%m\test_cyclic_rc-%PLATFORM%-%CONFIG%.exe" > test_mt%%m.txt
+    if errorlevel 1 exit /b 1
+
+    rem failed tests print messages ending with "!" or containing "invalid"
+    findstr /c:"finished" test_mt%%m.txt > nul
+    if errorlevel 1 exit /b 1
+
+    findstr "! invalid" test_mt%%m.txt
+    if not errorlevel 1 exit /b 1
+)
+
+echo all modes passed